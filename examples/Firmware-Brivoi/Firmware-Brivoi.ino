@@ -33,12 +33,16 @@ const float BRIVOI_ROTATE_DEGREES     = 90.0;  // degrees
 const float BRIVOI_ROTATE_DEGREES_ALT = 45.0;  // degrees
 const float BRIVOI_DIAGONAL_DISTANCE  = sqrt(2 * square(BRIVOI_MOVE_DISTANCE)); // Pythagoras, valid for 90/45
 
+// Diagonal warning = 3 blinks, ending on (non-blocking)
+const EB_T_LED_PATTERN DIAGONAL_PATTERN = {200, 200, 3};  // on ms, off ms, times
+
 #define BEEP_DURATION_SHORT 100  // ms
 #define BEEP_DURATION_LONG  200  // ms
 #define RTTTL_STARTUP ":d=16,o=6,b=140:c,p,e,p,g,"
 #define RTTTL_FINISH  ":d=16,o=6,b=800:f,4p,f,4p,f,4p,f,4p,c,4p,c,4p,c,4p,c,"
 #define RTTTL_PRESET  ":d=16,o=7,b=160:d#,e,f#,d#,"  // Program RESET
 #define RTTTL_MODECHG ":d=16,o=7,b=140:f,p,d,2p,"    // Mode change
+#define RTTTL_RESTORE ":d=16,o=7,b=160:c,e,g,"      // Program restored (EEPROM)
 
 #define PROGRAMMING 0
 #define EXECUTING   1
@@ -48,12 +52,10 @@ uint8_t status = PROGRAMMING;
 #define DONTRESET 2
 uint8_t mode = STANDARD;
 
-EB_T_COMMANDS program[128];  // list of actions saved
-uint8_t program_count = 0;   // number of commands in the program
-uint8_t program_index = 0;   // current command
 bool    is_diagonal = false; // indicates whether the next move is a diagonal
 
 Escornabot brivoi;
+ProgramRunner program(brivoi);  // list of actions saved, and its execution
 uint32_t currentTime;
 
 /*
@@ -94,8 +96,20 @@ void setup()
 	Serial.flush();
 	// do initial show
 	startUpShow();
+	// last program restored from the EEPROM (init): GO runs it
+	if (program.getCount() > 0)
+	{
+		Serial.print(F("\nProgram restored: "));
+		Serial.println(program.getCount());
+		delay(200);
+		brivoi.playRTTTL(RTTTL_RESTORE);
+	}
 	// purge serial queue
 	while (Serial.read() != -1);
+	// let remote apps upload/download the whole program at once
+	brivoi.setRemoteProgram(&program);
+	// distances and angles of the commands
+	setDiagonal(false);
 	// fix problem with swapped cables in steppers
 	#if STEPPERMOTOR_FIXED_REVERSED
 	brivoi.fixReversed();
@@ -114,11 +128,19 @@ void loop()
 	// watch standby
 	brivoi.handleStandby(currentTime);
 
+	// watch LED
+	brivoi.handleLED(currentTime);
+
 	// watch keypad
 	uint8_t kp_code = brivoi.handleKeypad(currentTime);
 
 	// watch serial/bluetooth
-	uint8_t bt_code = brivoi.handleSerial();
+	uint8_t bt_code = brivoi.handleRemote(currentTime);
+	if (bt_code == EB_RM_EVT_PROGRAM)
+	{
+		programUploaded();
+		bt_code = 0;
+	}
 
 	// conduct!
 	switch (status)
@@ -173,22 +195,43 @@ void showCmdColor(EB_T_COMMANDS cmd)
 	}
 }  // showCmdColor()
 
+/**
+ * Sets the diagonal status, and the distance of the next moves accordingly.
+ *
+ * @param diagonal  Whether the next move is a diagonal.
+ */
+void setDiagonal(bool diagonal)
+{
+	is_diagonal = diagonal;
+	program.setValues(is_diagonal ? BRIVOI_DIAGONAL_DISTANCE : BRIVOI_MOVE_DISTANCE, BRIVOI_ROTATE_DEGREES, BRIVOI_ROTATE_DEGREES_ALT);
+}  // setDiagonal()
+
+/**
+ * Clears our program/list, in the EEPROM too.
+ */
+void clearProgram()
+{
+	program.clear();
+	program.save();
+}  // clearProgram()
+
 /**
  * Add a command to our program/list.
  */
 void addCommand(EB_T_COMMANDS command)
 {
-	if (program_count >= sizeof(program))
+	if (! program.append(command))
 	{
+		// full
 		status = EXECUTING; // GO!
+		program.start(currentTime);
 		return;
 	}
-	program[program_count] = command;
-	program_count ++;
+	program.save(); // every change, kept after a power cut (restored at init)
 
 	#ifdef DEBUG_MODE
 	Serial.print(F("ADDED "));
-	Serial.println(EB_CMD_LABELS[command]);
+	Serial.println(brivoi.getCommandLabel(command));
 	#endif
 }  // addCommand()
 
@@ -198,17 +241,16 @@ void addCommand(EB_T_COMMANDS command)
 void stop(uint32_t currentTime)
 {
 	// shutdown execution
-	brivoi.stopAction(currentTime);
+	program.stop(currentTime);
 	brivoi.disableStepperMotors();
 	brivoi.clearKeypad(currentTime);
 	brivoi.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
 	if (mode == STANDARD)
-		program_count = 0;  // reset program
+		clearProgram();  // reset program
 	else
-		is_diagonal = false;  // reset diagonal status
-	program_index = 0;  // reset execution pointer
+		setDiagonal(false);  // reset diagonal status
 	if (! is_diagonal) brivoi.turnLED(OFF); // input status
-	else brivoi.blinkLED(3, true); // diagonal!
+	else brivoi.startLEDPattern(DIAGONAL_PATTERN, true); // diagonal!
 	status = PROGRAMMING; // back to user input
 
 	#ifdef DEBUG_MODE
@@ -218,6 +260,23 @@ void stop(uint32_t currentTime)
 	delay(500); // allow some time for sound and key stroke clearance
 }  // stop()
 
+/**
+ * A whole program has just been uploaded remotely: ready to GO.
+ */
+void programUploaded()
+{
+	// (refused by the library while executing)
+	setDiagonal(false);  // reset diagonal status
+	program.save();  // into the EEPROM too
+	brivoi.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
+	brivoi.turnLED(OFF); // input status
+
+	#ifdef DEBUG_MODE
+	Serial.print(F("UPLOADED "));
+	Serial.println(program.getCount());
+	#endif
+}  // programUploaded()
+
 /**
  * Takes care of the keypad and what to do when some key is used.
  *
@@ -250,9 +309,10 @@ void processKeyStroke(uint8_t kp_code)
 			brivoi.turnLED(ON);
 			brivoi.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
 
-			if (program_count < 1) break;
+			if (program.getCount() < 1) break;
 
 			status = EXECUTING;
+			program.start(currentTime);
 
 			#ifdef DEBUG_MODE
 			Serial.println(F("GO!"));
@@ -276,7 +336,7 @@ void processKeyStroke(uint8_t kp_code)
 		// go back to "input color" after a moment
 		delay(BEEP_DURATION_SHORT + 50);
 		if (! is_diagonal) brivoi.turnLED(OFF); // input status
-		else brivoi.blinkLED(3, true); // diagonal!
+		else brivoi.startLEDPattern(DIAGONAL_PATTERN, true); // diagonal!
 	}
 	// LONG key presses
 	else if (event == EB_KP_EVT_LONGPRESSED)
@@ -320,7 +380,7 @@ void processKeyStroke(uint8_t kp_code)
 			// check if there is something to reset
 			if
 			(
-				(program_count < 1) // no program
+				(program.getCount() < 1) // no program
 				&& (! is_diagonal)  // no diagonal angle
 			) break; // nothing to do here
 			// program reset!!
@@ -328,9 +388,8 @@ void processKeyStroke(uint8_t kp_code)
 			brivoi.turnLED(OFF);  // RESET = Off
 			delay(BEEP_DURATION_LONG * 5);
 			brivoi.playRTTTL(RTTTL_PRESET);
-			program_count = 0;   // reset program
-			program_index = 0;   // reset execution pointer
-			is_diagonal = false; // reset diagonal status
+			clearProgram();      // reset program
+			setDiagonal(false);  // reset diagonal status
 			break;
 		default:
 			return; // unhandled case, avoid any further action
@@ -338,7 +397,7 @@ void processKeyStroke(uint8_t kp_code)
 		// go back to "input color" after a moment
 		delay(BEEP_DURATION_LONG + 50);
 		if (! is_diagonal) brivoi.turnLED(OFF); // input status
-		else brivoi.blinkLED(3, true); // diagonal!
+		else brivoi.startLEDPattern(DIAGONAL_PATTERN, true); // diagonal!
 	}
 }  // processKeyStroke()
 
@@ -352,85 +411,59 @@ void processKeyStroke(uint8_t kp_code)
  */
 void processProgram()
 {
-	// continue executing pending action (if any)
-	switch (brivoi.handleAction(currentTime, program[program_index]))
+	switch (program.handleProgram(currentTime))
 	{
-	case EB_CMD_R_PENDING_ACTION:
-		return;  // still pending execution -> exit to the next loop
-
-	case EB_CMD_R_FINISHED_ACTION:  // next command
-		program_index ++;  // <- no "break" necessary
-
-	case EB_CMD_R_NOTHING_TO_DO:
-	default:
-		// process next command
-		if (program_index < program_count)
+	case EB_PR_R_NEXT:
+	{
+		// a command has just started: feedback
+		EB_T_COMMANDS command = program.getCommand(program.getIndex());
+		showCmdColor(command);
+		switch (command)
 		{
-			// process command
-			if (program_index == 0) delay(600); // small pause before starting
-
-			switch (program[program_index])
-			{
-			case EB_CMD_FW:
-				showCmdColor(program[program_index]);
-				brivoi.beep(EB_BEEP_FORWARD, BEEP_DURATION_SHORT);
-				if (! is_diagonal) brivoi.prepareAction(EB_CMD_FW, BRIVOI_MOVE_DISTANCE);
-				else brivoi.prepareAction(EB_CMD_FW, BRIVOI_DIAGONAL_DISTANCE);
-				break;
-			case EB_CMD_TL:
-				showCmdColor(program[program_index]);
-				brivoi.beep(EB_BEEP_TURNLEFT, BEEP_DURATION_SHORT);
-				brivoi.prepareAction(EB_CMD_TL, BRIVOI_ROTATE_DEGREES);
-				break;
-			case EB_CMD_TR:
-				showCmdColor(program[program_index]);
-				brivoi.beep(EB_BEEP_TURNRIGHT, BEEP_DURATION_SHORT);
-				brivoi.prepareAction(EB_CMD_TR, BRIVOI_ROTATE_DEGREES);
-				break;
-			case EB_CMD_BW:
-				showCmdColor(program[program_index]);
-				brivoi.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
-				if (! is_diagonal) brivoi.prepareAction(EB_CMD_BW, BRIVOI_MOVE_DISTANCE);
-				else brivoi.prepareAction(EB_CMD_BW, BRIVOI_DIAGONAL_DISTANCE);
-				break;
-			case EB_CMD_PA:
-				showCmdColor(program[program_index]);
-				brivoi.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
-				brivoi.prepareAction(EB_CMD_BW, BRIVOI_MOVE_DISTANCE); // same time as the movement
-				break;
-			case EB_CMD_TL_ALT:
-				showCmdColor(program[program_index]);
-				// Note = C#7, between C (TL) & D (FW)
-				brivoi.playTone(2217, BEEP_DURATION_SHORT, false);
-				brivoi.prepareAction(EB_CMD_TL_ALT, BRIVOI_ROTATE_DEGREES_ALT); // half degrees
-				is_diagonal = ! is_diagonal;
-				break;
-			case EB_CMD_TR_ALT:
-				showCmdColor(program[program_index]);
-				// Note = D#7, between D (FW) & E (TR)
-				brivoi.playTone(2489, BEEP_DURATION_SHORT, false);
-				brivoi.prepareAction(EB_CMD_TR_ALT, BRIVOI_ROTATE_DEGREES_ALT); // half degrees
-				is_diagonal = ! is_diagonal;
-				break;
-			}
+		case EB_CMD_FW:
+			brivoi.beep(EB_BEEP_FORWARD, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TL:
+			brivoi.beep(EB_BEEP_TURNLEFT, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TR:
+			brivoi.beep(EB_BEEP_TURNRIGHT, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_BW:
+		case EB_CMD_PA:
+			brivoi.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TL_ALT:
+			// Note = C#7, between C (TL) & D (FW)
+			brivoi.playTone(2217, BEEP_DURATION_SHORT, false);
+			setDiagonal(! is_diagonal);  // for the next moves
+			break;
+		case EB_CMD_TR_ALT:
+			// Note = D#7, between D (FW) & E (TR)
+			brivoi.playTone(2489, BEEP_DURATION_SHORT, false);
+			setDiagonal(! is_diagonal);  // for the next moves
+			break;
 		}
+		break;
+	}
+	case EB_PR_R_IDLE:
+		// stopped remotely (STOP frame)
+		stop(currentTime);
+		break;
+	case EB_PR_R_FINISHED:
+		// execution finished
+		if (mode == STANDARD)
+			clearProgram();      // reset program
 		else
-		{
-			// execution finished
-			if (mode == STANDARD)
-				program_count = 0;   // reset program
-			else
-				is_diagonal = false; // reset diagonal status
-			program_index = 0;       // reset execution pointer
-			brivoi.disableStepperMotors();
-			brivoi.playRTTTL(RTTTL_FINISH);
-			if (! is_diagonal) brivoi.turnLED(OFF); // input status
-			else brivoi.blinkLED(3, true); // diagonal!
-			status = PROGRAMMING; // back to user input
+			setDiagonal(false);  // reset diagonal status
+		brivoi.disableStepperMotors();
+		brivoi.playRTTTL(RTTTL_FINISH);
+		if (! is_diagonal) brivoi.turnLED(OFF); // input status
+		else brivoi.startLEDPattern(DIAGONAL_PATTERN, true); // diagonal!
+		status = PROGRAMMING; // back to user input
 
-			#ifdef DEBUG_MODE
-			Serial.println(F("FINISHED"));
-			#endif
-		}
-	} // switch
+		#ifdef DEBUG_MODE
+		Serial.println(F("FINISHED"));
+		#endif
+	}  // switch
 }  // processProgram()
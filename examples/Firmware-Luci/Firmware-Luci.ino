@@ -19,8 +19,14 @@
 #define FIRMWARE_VERSION "1.2.3"
 // change this to true if your stepper motors work backwards.
 #define STEPPERMOTOR_FIXED_REVERSED false
-// uncomment the following line if you want to see debug information (via serial)
-//#define DEBUG_MODE
+// debug information: enable EB_DEBUG_MODE in the library Config.h, the events
+// are logged in RAM and sent while idle (decode them with extras/decode_log.py
+// --events Firmware-Luci.ino, which takes the names below)
+#define LOG_ADDED    (EB_LOG_USER + 0)  // a = command
+#define LOG_STOP     (EB_LOG_USER + 1)
+#define LOG_UPLOADED (EB_LOG_USER + 2)  // a = count (commands)
+#define LOG_GO       (EB_LOG_USER + 3)  // a = count (commands)
+#define LOG_FINISHED (EB_LOG_USER + 4)
 
 #include <Arduino.h>
 #include <Escornabot-lib.h>
@@ -32,13 +38,13 @@ const float LUCI_ROTATE_DEGREES_ALT = 45.0;  // degrees
 const float LUCI_DIAGONAL_DISTANCE  = sqrt(2 * square(LUCI_MOVE_DISTANCE)); // Pythagoras, valid for 90/45
 
 // Luci color = Purple (~ darkish magenta)
-#define LUCI_COLOR_R BRIGHTNESS_LEVEL * 0.4
+#define LUCI_COLOR_R (BRIGHTNESS_LEVEL * 2 / 5)  // 40%
 #define LUCI_COLOR_G 0
 #define LUCI_COLOR_B BRIGHTNESS_LEVEL
 
 // Diagonal warning color = Orange
 #define DIAGONAL_COLOR_R BRIGHTNESS_LEVEL
-#define DIAGONAL_COLOR_G BRIGHTNESS_LEVEL * 0.4
+#define DIAGONAL_COLOR_G (BRIGHTNESS_LEVEL * 2 / 5)  // 40%
 #define DIAGONAL_COLOR_B 0
 
 #define BEEP_DURATION_SHORT 100  // ms
@@ -47,6 +53,7 @@ const float LUCI_DIAGONAL_DISTANCE  = sqrt(2 * square(LUCI_MOVE_DISTANCE)); // P
 #define RTTTL_FINISH  ":d=16,o=6,b=800:f,4p,f,4p,f,4p,f,4p,c,4p,c,4p,c,4p,c,"
 #define RTTTL_PRESET  ":d=16,o=7,b=160:d#,e,f#,d#,"  // Program RESET
 #define RTTTL_MODECHG ":d=16,o=7,b=140:f,p,d,2p,"    // Mode change
+#define RTTTL_RESTORE ":d=16,o=7,b=160:c,e,g,"      // Program restored (EEPROM)
 
 #define PROGRAMMING 0
 #define EXECUTING   1
@@ -56,12 +63,10 @@ uint8_t status = PROGRAMMING;
 #define DONTRESET 2
 uint8_t mode = STANDARD;
 
-EB_T_COMMANDS program[128];  // list of actions saved
-uint8_t program_count = 0;   // number of commands in the program
-uint8_t program_index = 0;   // current command
 bool    is_diagonal = false; // indicates whether the next move is a diagonal
 
 Escornabot luci;
+ProgramRunner program(luci);  // list of actions saved, and its execution
 uint32_t currentTime;
 
 /*
@@ -92,8 +97,20 @@ void setup()
 	Serial.flush();
 	// do initial show
 	startUpShow();
+	// last program restored from the EEPROM (init): GO runs it
+	if (program.getCount() > 0)
+	{
+		Serial.print(F("\nProgram restored: "));
+		Serial.println(program.getCount());
+		delay(200);
+		luci.playRTTTL(RTTTL_RESTORE);
+	}
 	// purge serial queue
 	while (Serial.read() != -1);
+	// let remote apps upload/download the whole program at once
+	luci.setRemoteProgram(&program);
+	// distances and angles of the commands
+	setDiagonal(false);
 	// fix problem with swapped cables in steppers
 	#if STEPPERMOTOR_FIXED_REVERSED
 	luci.fixReversed();
@@ -116,7 +133,12 @@ void loop()
 	uint8_t kp_code = luci.handleKeypad(currentTime);
 
 	// watch serial/bluetooth
-	uint8_t bt_code = luci.handleSerial();
+	uint8_t bt_code = luci.handleRemote(currentTime);
+	if (bt_code == EB_RM_EVT_PROGRAM)
+	{
+		programUploaded();
+		bt_code = 0;
+	}
 
 	// conduct!
 	switch (status)
@@ -196,23 +218,41 @@ void showCmdColor(EB_T_COMMANDS cmd)
 	}
 }  // showCmdColor()
 
+/**
+ * Sets the diagonal status, and the distance of the next moves accordingly.
+ *
+ * @param diagonal  Whether the next move is a diagonal.
+ */
+void setDiagonal(bool diagonal)
+{
+	is_diagonal = diagonal;
+	program.setValues(is_diagonal ? LUCI_DIAGONAL_DISTANCE : LUCI_MOVE_DISTANCE, LUCI_ROTATE_DEGREES, LUCI_ROTATE_DEGREES_ALT);
+}  // setDiagonal()
+
+/**
+ * Clears our program/list, in the EEPROM too.
+ */
+void clearProgram()
+{
+	program.clear();
+	program.save();
+}  // clearProgram()
+
 /**
  * Add a command to our program/list.
  */
 void addCommand(EB_T_COMMANDS command)
 {
-	if (program_count >= sizeof(program))
+	if (! program.append(command))
 	{
+		// full
 		status = EXECUTING; // GO!
+		program.start(currentTime);
 		return;
 	}
-	program[program_count] = command;
-	program_count ++;
+	program.save(); // every change, kept after a power cut (restored at init)
 
-	#ifdef DEBUG_MODE
-	Serial.print(F("ADDED "));
-	Serial.println(EB_CMD_LABELS[command]);
-	#endif
+	luci.logEvent(LOG_ADDED, command);
 }  // addCommand()
 
 /**
@@ -221,26 +261,37 @@ void addCommand(EB_T_COMMANDS command)
 void stop(uint32_t currentTime)
 {
 	// shutdown execution
-	luci.stopAction(currentTime);
+	program.stop(currentTime);
 	luci.disableStepperMotors();
 	luci.clearKeypad(currentTime);
 	luci.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
 	if (mode == STANDARD)
-		program_count = 0;  // reset program
+		clearProgram();  // reset program
 	else
-		is_diagonal = false;  // reset diagonal status
-	program_index = 0;  // reset execution pointer
+		setDiagonal(false);  // reset diagonal status
 	if (! is_diagonal) luci.showColor(LUCI_COLOR_R, LUCI_COLOR_G, LUCI_COLOR_B); // input color, purple
 	else luci.showColor(DIAGONAL_COLOR_R, DIAGONAL_COLOR_G, DIAGONAL_COLOR_B); // diagonal!
 	status = PROGRAMMING;  // back to user input
 
-	#ifdef DEBUG_MODE
-	Serial.println(F("STOP!"));
-	#endif
+	luci.logEvent(LOG_STOP);
 
 	delay(500); // allow some time for sound and key stroke clearance
 }  // stop()
 
+/**
+ * A whole program has just been uploaded remotely: ready to GO.
+ */
+void programUploaded()
+{
+	// (refused by the library while executing)
+	setDiagonal(false);  // reset diagonal status
+	program.save();  // into the EEPROM too
+	luci.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
+	luci.showColor(LUCI_COLOR_R, LUCI_COLOR_G, LUCI_COLOR_B); // input color, purple
+
+	luci.logEvent(LOG_UPLOADED, program.getCount());
+}  // programUploaded()
+
 /**
  * Takes care of the keypad and what to do when some key is used.
  *
@@ -273,13 +324,12 @@ void processKeyStroke(uint8_t kp_code)
 			luci.showKeyColor(key);
 			luci.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
 
-			if (program_count < 1) break;
+			if (program.getCount() < 1) break;
 
 			status = EXECUTING;
+			program.start(currentTime);
 
-			#ifdef DEBUG_MODE
-			Serial.println(F("GO!"));
-			#endif
+			luci.logEvent(LOG_GO, program.getCount());
 
 			break;
 		case EB_KP_KEY_TR:
@@ -343,7 +393,7 @@ void processKeyStroke(uint8_t kp_code)
 			// check if there is something to reset
 			if
 			(
-				(program_count < 1) // no program
+				(program.getCount() < 1) // no program
 				&& (! is_diagonal)  // no diagonal angle
 			) break; // nothing to do here
 			// program reset!!
@@ -351,9 +401,8 @@ void processKeyStroke(uint8_t kp_code)
 			luci.showKeyColor(EB_KP_KEY_NN); // RESET = Off
 			delay(BEEP_DURATION_LONG * 5);
 			luci.playRTTTL(RTTTL_PRESET);
-			program_count = 0;   // reset program
-			program_index = 0;   // reset execution pointer
-			is_diagonal = false; // reset diagonal status
+			clearProgram();      // reset program
+			setDiagonal(false);  // reset diagonal status
 			break;
 		default:
 			return; // unhandled case, avoid any further action
@@ -375,85 +424,57 @@ void processKeyStroke(uint8_t kp_code)
  */
 void processProgram()
 {
-	// continue executing pending action (if any)
-	switch (luci.handleAction(currentTime, program[program_index]))
+	switch (program.handleProgram(currentTime))
 	{
-	case EB_CMD_R_PENDING_ACTION:
-		return;  // still pending execution -> exit to the next loop
-
-	case EB_CMD_R_FINISHED_ACTION:  // next command
-		program_index ++;  // <- no "break" necessary
-
-	case EB_CMD_R_NOTHING_TO_DO:
-	default:
-		// process next command
-		if (program_index < program_count)
+	case EB_PR_R_NEXT:
+	{
+		// a command has just started: feedback
+		EB_T_COMMANDS command = program.getCommand(program.getIndex());
+		showCmdColor(command);
+		switch (command)
 		{
-			// process command
-			if (program_index == 0) delay(600); // small pause before starting
-
-			switch (program[program_index])
-			{
-			case EB_CMD_FW:
-				showCmdColor(program[program_index]);
-				luci.beep(EB_BEEP_FORWARD, BEEP_DURATION_SHORT);
-				if (! is_diagonal) luci.prepareAction(EB_CMD_FW, LUCI_MOVE_DISTANCE);
-				else luci.prepareAction(EB_CMD_FW, LUCI_DIAGONAL_DISTANCE);
-				break;
-			case EB_CMD_TL:
-				showCmdColor(program[program_index]);
-				luci.beep(EB_BEEP_TURNLEFT, BEEP_DURATION_SHORT);
-				luci.prepareAction(EB_CMD_TL, LUCI_ROTATE_DEGREES);
-				break;
-			case EB_CMD_TR:
-				showCmdColor(program[program_index]);
-				luci.beep(EB_BEEP_TURNRIGHT, BEEP_DURATION_SHORT);
-				luci.prepareAction(EB_CMD_TR, LUCI_ROTATE_DEGREES);
-				break;
-			case EB_CMD_BW:
-				showCmdColor(program[program_index]);
-				luci.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
-				if (! is_diagonal) luci.prepareAction(EB_CMD_BW, LUCI_MOVE_DISTANCE);
-				else luci.prepareAction(EB_CMD_BW, LUCI_DIAGONAL_DISTANCE);
-				break;
-			case EB_CMD_PA:
-				showCmdColor(program[program_index]);
-				luci.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
-				luci.prepareAction(EB_CMD_BW, LUCI_MOVE_DISTANCE); // same time as the movement
-				break;
-			case EB_CMD_TL_ALT:
-				showCmdColor(program[program_index]);
-				// Note = C#7, between C (TL) & D (FW)
-				luci.playTone(2217, BEEP_DURATION_SHORT, false);
-				luci.prepareAction(EB_CMD_TL_ALT, LUCI_ROTATE_DEGREES_ALT); // half degrees
-				is_diagonal = ! is_diagonal;
-				break;
-			case EB_CMD_TR_ALT:
-				showCmdColor(program[program_index]);
-				// Note = D#7, between D (FW) & E (TR)
-				luci.playTone(2489, BEEP_DURATION_SHORT, false);
-				luci.prepareAction(EB_CMD_TR_ALT, LUCI_ROTATE_DEGREES_ALT); // half degrees
-				is_diagonal = ! is_diagonal;
-				break;
-			}
+		case EB_CMD_FW:
+			luci.beep(EB_BEEP_FORWARD, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TL:
+			luci.beep(EB_BEEP_TURNLEFT, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TR:
+			luci.beep(EB_BEEP_TURNRIGHT, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_BW:
+		case EB_CMD_PA:
+			luci.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TL_ALT:
+			// Note = C#7, between C (TL) & D (FW)
+			luci.playTone(2217, BEEP_DURATION_SHORT, false);
+			setDiagonal(! is_diagonal);  // for the next moves
+			break;
+		case EB_CMD_TR_ALT:
+			// Note = D#7, between D (FW) & E (TR)
+			luci.playTone(2489, BEEP_DURATION_SHORT, false);
+			setDiagonal(! is_diagonal);  // for the next moves
+			break;
 		}
+		break;
+	}
+	case EB_PR_R_IDLE:
+		// stopped remotely (STOP frame)
+		stop(currentTime);
+		break;
+	case EB_PR_R_FINISHED:
+		// execution finished
+		if (mode == STANDARD)
+			clearProgram();      // reset program
 		else
-		{
-			// execution finished
-			if (mode == STANDARD)
-				program_count = 0;   // reset program
-			else
-				is_diagonal = false; // reset diagonal status
-			program_index = 0;       // reset execution pointer
-			luci.disableStepperMotors();
-			luci.playRTTTL(RTTTL_FINISH);
-			if (! is_diagonal) luci.showColor(LUCI_COLOR_R, LUCI_COLOR_G, LUCI_COLOR_B); // input color, purple
-			else luci.showColor(DIAGONAL_COLOR_R, DIAGONAL_COLOR_G, DIAGONAL_COLOR_B); // diagonal!
-			status = PROGRAMMING; // back to user input
-
-			#ifdef DEBUG_MODE
-			Serial.println(F("FINISHED"));
-			#endif
-		}
-	} // switch
+			setDiagonal(false);  // reset diagonal status
+		luci.disableStepperMotors();
+		luci.playRTTTL(RTTTL_FINISH);
+		if (! is_diagonal) luci.showColor(LUCI_COLOR_R, LUCI_COLOR_G, LUCI_COLOR_B); // input color, purple
+		else luci.showColor(DIAGONAL_COLOR_R, DIAGONAL_COLOR_G, DIAGONAL_COLOR_B); // diagonal!
+		status = PROGRAMMING; // back to user input
+
+		luci.logEvent(LOG_FINISHED);
+	}  // switch
 }  // processProgram()
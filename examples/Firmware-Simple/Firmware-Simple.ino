@@ -27,23 +27,21 @@ const float ROBOT_MOVE_DISTANCE      = 10.0;  // cms
 const float ROBOT_ROTATE_DEGREES     = 90.0;  // degrees
 
 // Luci color = Purple (~ darkish magenta)
-#define ROBOT_COLOR_R BRIGHTNESS_LEVEL * 0.4
+#define ROBOT_COLOR_R (BRIGHTNESS_LEVEL * 2 / 5)  // 40%
 #define ROBOT_COLOR_G 0
 #define ROBOT_COLOR_B BRIGHTNESS_LEVEL
 
 #define BEEP_DURATION_SHORT 100  // ms
 #define RTTTL_STARTUP ":d=16,o=6,b=140:c,p,e,p,g,"
 #define RTTTL_FINISH  ":d=16,o=6,b=800:f,4p,f,4p,f,4p,f,4p,c,4p,c,4p,c,4p,c,"
+#define RTTTL_RESTORE ":d=16,o=7,b=160:c,e,g,"  // Program restored (EEPROM)
 
 #define PROGRAMMING 0
 #define EXECUTING   1
 uint8_t status = PROGRAMMING;
 
-EB_T_COMMANDS program[128];  // list of actions saved
-uint8_t program_count = 0;   // number of commands in the program
-uint8_t program_index = 0;   // current command
-
 Escornabot robot;
+ProgramRunner program(robot);  // list of actions saved, and its execution
 uint32_t currentTime;
 
 /*
@@ -74,8 +72,18 @@ void setup()
 	Serial.flush();
 	// do initial show
 	startUpShow();
+	// last program restored from the EEPROM (init): GO runs it
+	if (program.getCount() > 0)
+	{
+		Serial.print(F("\nProgram restored: "));
+		Serial.println(program.getCount());
+		delay(200);
+		robot.playRTTTL(RTTTL_RESTORE);
+	}
 	// purge serial queue
 	while (Serial.read() != -1);
+	// distances and angles of the commands
+	program.setValues(ROBOT_MOVE_DISTANCE, ROBOT_ROTATE_DEGREES, ROBOT_ROTATE_DEGREES / 2);
 	// fix problem with swapped cables in steppers
 	#if STEPPERMOTOR_FIXED_REVERSED
 	robot.fixReversed();
@@ -169,18 +177,28 @@ void showCmdColor(EB_T_COMMANDS cmd)
 	}
 }  // showCmdColor()
 
+/**
+ * Clears our program/list, in the EEPROM too.
+ */
+void clearProgram()
+{
+	program.clear();
+	program.save();
+}  // clearProgram()
+
 /**
  * Add a command to our program/list.
  */
 void addCommand(EB_T_COMMANDS command)
 {
-	if (program_count >= sizeof(program))
+	if (! program.append(command))
 	{
+		// full
 		status = EXECUTING; // GO!
+		program.start(currentTime);
 		return;
 	}
-	program[program_count] = command;
-	program_count ++;
+	program.save(); // every change, kept after a power cut (restored at init)
 }  // addCommand()
 
 /**
@@ -189,12 +207,11 @@ void addCommand(EB_T_COMMANDS command)
 void stop(uint32_t currentTime)
 {
 	// shutdown execution
-	robot.stopAction(currentTime);
+	program.stop(currentTime);
 	robot.disableStepperMotors();
 	robot.clearKeypad(currentTime);
 	robot.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
-	program_count = 0;  // reset program
-	program_index = 0;  // reset execution pointer
+	clearProgram();  // reset program
 	robot.showColor(ROBOT_COLOR_R, ROBOT_COLOR_G, ROBOT_COLOR_B); // input color, purple
 	status = PROGRAMMING;  // back to user input
 	delay(500); // allow some time for sound and key stroke clearance
@@ -231,8 +248,9 @@ void processKeyStroke(uint8_t kp_code)
 		case EB_KP_KEY_GO:
 			robot.showKeyColor(key);
 			robot.beep(EB_BEEP_DEFAULT, BEEP_DURATION_SHORT);
-			if (program_count < 1) break;
+			if (program.getCount() < 1) break;
 			status = EXECUTING;
+			program.start(currentTime);
 			break;
 		case EB_KP_KEY_TR:
 			robot.showKeyColor(key);
@@ -264,55 +282,35 @@ void processKeyStroke(uint8_t kp_code)
  */
 void processProgram()
 {
-	// continue executing pending action (if any)
-	switch (robot.handleAction(currentTime, program[program_index]))
+	switch (program.handleProgram(currentTime))
 	{
-	case EB_CMD_R_PENDING_ACTION:
-		return;  // still pending execution -> exit to the next loop
-
-	case EB_CMD_R_FINISHED_ACTION:  // next command
-		program_index ++;  // <- no "break" necessary
-
-	case EB_CMD_R_NOTHING_TO_DO:
-	default:
-		// process next command
-		if (program_index < program_count)
-		{
-			// process command
-			if (program_index == 0) delay(600); // small pause before starting
-
-			switch (program[program_index])
-			{
-			case EB_CMD_FW:
-				showCmdColor(program[program_index]);
-				robot.beep(EB_BEEP_FORWARD, BEEP_DURATION_SHORT);
-				robot.prepareAction(EB_CMD_FW, ROBOT_MOVE_DISTANCE);
-				break;
-			case EB_CMD_TL:
-				showCmdColor(program[program_index]);
-				robot.beep(EB_BEEP_TURNLEFT, BEEP_DURATION_SHORT);
-				robot.prepareAction(EB_CMD_TL, ROBOT_ROTATE_DEGREES);
-				break;
-			case EB_CMD_TR:
-				showCmdColor(program[program_index]);
-				robot.beep(EB_BEEP_TURNRIGHT, BEEP_DURATION_SHORT);
-				robot.prepareAction(EB_CMD_TR, ROBOT_ROTATE_DEGREES);
-				break;
-			case EB_CMD_BW:
-				showCmdColor(program[program_index]);
-				robot.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
-				robot.prepareAction(EB_CMD_BW, ROBOT_MOVE_DISTANCE);
-			}
-		}
-		else
+	case EB_PR_R_NEXT:
+	{
+		// a command has just started: feedback
+		EB_T_COMMANDS command = program.getCommand(program.getIndex());
+		showCmdColor(command);
+		switch (command)
 		{
-			// execution finished
-			program_count = 0;  // reset program
-			program_index = 0;  // reset execution pointer
-			robot.disableStepperMotors();
-			robot.playRTTTL(RTTTL_FINISH);
-			robot.showColor(ROBOT_COLOR_R, ROBOT_COLOR_G, ROBOT_COLOR_B); // input color, purple
-			status = PROGRAMMING; // back to user input
+		case EB_CMD_FW:
+			robot.beep(EB_BEEP_FORWARD, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TL:
+			robot.beep(EB_BEEP_TURNLEFT, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_TR:
+			robot.beep(EB_BEEP_TURNRIGHT, BEEP_DURATION_SHORT);
+			break;
+		case EB_CMD_BW:
+			robot.beep(EB_BEEP_BACKWARD, BEEP_DURATION_SHORT);
 		}
-	} // switch
+		break;
+	}
+	case EB_PR_R_FINISHED:
+		// execution finished
+		clearProgram();  // reset program
+		robot.disableStepperMotors();
+		robot.playRTTTL(RTTTL_FINISH);
+		robot.showColor(ROBOT_COLOR_R, ROBOT_COLOR_G, ROBOT_COLOR_B); // input color, purple
+		status = PROGRAMMING; // back to user input
+	}  // switch
 }  // processProgram()
@@ -0,0 +1,58 @@
+/**
+ * Escornabot-lib input queue example: no key stroke is lost
+ *
+ * With the input queue running, the keypad readings are recorded in the
+ * background, and getInputEvent() turns them (and the bytes received through
+ * the Serial port) into events with their timestamps, so they can be
+ * consumed later, at any pace, even after a long blocking delay().
+ *
+ * Press several keys during the 3 seconds pause: all of them will be shown.
+ * (EB_KEYPAD_SAMPLER must be defined in Config.h, else they are lost).
+ * A short key press, during the pause or right after it, shows just PRESSED
+ * and RELEASED, with the time it was held: never a LONGPRESSED.
+ */
+
+#include <Escornabot-lib.h>
+Escornabot luci; // create Escornabot object
+
+void setup()
+{
+	// setup luci
+	luci.init(); // 9600 baudrate
+	// banner
+	Serial.println("Escornalib input queue test for Luci");
+	// start-up sequence: beep + Luci color
+	luci.beep(EB_BEEP_DEFAULT, 100);
+	luci.showColor(50, 0, 20); // purple
+	// process inputs in the background from now on
+	luci.startInputQueue();
+}  // setup()
+
+void loop()
+{
+	EB_T_INPUT_EVENT event;
+	static uint32_t pressed_time = 0; // last keypad PRESSED event
+
+	// consume all the events stored
+	while (luci.getInputEvent(event))
+	{
+		Serial.print(event.time);
+		Serial.print(event.source == EB_IN_SRC_KEYPAD ? " KEYPAD " : " SERIAL ");
+		Serial.print(luci.getKeyLabel(event.code & B1111)); // low nibble
+		Serial.print(" EVENT ");
+		Serial.print(event.code >> 4); // high nibble
+		if (event.source == EB_IN_SRC_KEYPAD && (event.code >> 4) == EB_KP_EVT_PRESSED)
+			pressed_time = event.time;
+		if (event.source == EB_IN_SRC_KEYPAD && (event.code >> 4) == EB_KP_EVT_RELEASED)
+		{
+			Serial.print(" held ");
+			Serial.print(event.time - pressed_time);
+			Serial.print(" ms");
+		}
+		Serial.println();
+	}
+	Serial.print("lost events: ");
+	Serial.println(luci.getInputOverflows());
+
+	delay(3000); // <-- NOTE: everything is blocked, but inputs are recorded
+}  // loop()
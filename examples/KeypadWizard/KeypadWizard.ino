@@ -0,0 +1,63 @@
+/**
+ * Escornabot-lib keypad configuration wizard example
+ *
+ * The wizard learns the analog value of every key and stores them in the
+ * EEPROM. It runs asynchronously, so it can be started at any time (here,
+ * sending 'c' through the Serial port) while the rest of the program goes on:
+ *   1. Start it with startKeypadWizard()
+ *   2. Call the wizard handler repeatedly (in the loop()) until it finishes
+ *
+ * After four beeps, press FW, TL, GO, TR and BW, one by one.
+ */
+
+#include <Escornabot-lib.h>
+Escornabot luci; // create Escornabot object
+
+void setup()
+{
+	// setup luci
+	luci.init(); // 9600 baudrate
+	// banner
+	Serial.println("Escornalib keypad wizard test for Luci");
+	Serial.println("Send 'c' to configure the keypad");
+	// start-up sequence: beep + Luci color
+	luci.beep(EB_BEEP_DEFAULT, 100);
+	luci.showColor(50, 0, 20); // purple
+}  // setup()
+
+void loop()
+{
+	uint32_t currentTime = millis();
+
+	if (Serial.read() == 'c')
+	{
+		luci.startKeypadWizard();
+		luci.showColor(50, 0, 0); // red: configuring
+	}
+
+	switch (luci.handleKeypadWizard(currentTime))
+	{
+	case EB_KP_WZ_R_SAVED:
+		Serial.println("Keypad values saved:");
+		for (uint8_t i = EB_KP_KEY_FW; i <= EB_KP_KEY_BW; i++)
+		{
+			Serial.print(luci.getKeyLabel(i));
+			Serial.print(" ");
+			Serial.println(luci.getKeypadValues()[i]);
+		}
+		luci.showColor(0, 50, 0); // green
+		break;
+	case EB_KP_WZ_R_INVALID:
+		Serial.println("Keys too close to each other, nothing saved");
+		luci.showColor(50, 50, 0); // yellow
+		break;
+	case EB_KP_WZ_R_TIMEOUT:
+		Serial.println("Timeout, nothing saved");
+		luci.showColor(50, 0, 20); // purple
+		break;
+	case EB_KP_WZ_R_IDLE:
+		// the keypad works as usual meanwhile
+		uint8_t code = luci.handleKeypad(currentTime);
+		if (code >> 4 == EB_KP_EVT_RELEASED) luci.showKeyColor((EB_T_KP_KEYS)(code & B1111));
+	}
+}  // loop()
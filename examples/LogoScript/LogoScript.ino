@@ -0,0 +1,44 @@
+/**
+ * Escornabot-lib Logo example: drive the robot with turtle scripts
+ *
+ * Type (or paste) scripts in the Serial Monitor, e.g.:
+ *
+ *   REPEAT 4 [FD 10 RT 90]
+ *
+ * FD/BK move (cms), RT/LT turn (degrees), REPEAT n [...] loops and STOP
+ * aborts everything. The robot starts moving before the whole script has
+ * arrived, so long scripts can be sent at once.
+ */
+
+#include <Escornabot-lib.h>
+Escornabot luci; // create Escornabot object
+
+void setup()
+{
+	// setup luci
+	luci.init(); // 9600 baudrate
+	// banner
+	Serial.println("Escornalib Logo interpreter for Luci");
+	// start-up sequence: beep + Luci color
+	luci.beep(EB_BEEP_DEFAULT, 100);
+	luci.showColor(50, 0, 20); // purple
+	// scripts through the Serial port from now on
+	luci.startLogo();
+}  // setup()
+
+void loop()
+{
+	uint32_t currentTime = millis(); // get time
+
+	switch (luci.handleLogo(currentTime))
+	{
+	case EB_LG_R_FINISHED:
+		luci.beep(EB_BEEP_DEFAULT, 100);
+		Serial.println("OK");
+		break;
+	case EB_LG_R_ERROR:
+		luci.beep(EB_BEEP_BACKWARD, 300);
+		Serial.println("? (line discarded)");
+		break;
+	}
+}  // loop()
@@ -0,0 +1,59 @@
+/**
+ * Escornabot-lib NeoPixel effects example: fades, breathing and pulses
+ *
+ * Light effects run asynchronously, so they don't block the rest of the
+ * program (keypad, movements...):
+ *   1. Start the effect with fadeToColor() or breatheColor()
+ *   2. Call the NeoPixel handler repeatedly (in the loop())
+ *
+ * Luci breathes purple while idle, fades to the color of every pressed key
+ * and pulses it twice when the key is released.
+ */
+
+#include <Escornabot-lib.h>
+Escornabot luci; // create Escornabot object
+
+void setup()
+{
+	// setup luci
+	luci.init(); // 9600 baudrate
+	// banner
+	Serial.println("Escornalib NeoPixel effects test for Luci");
+	// the first frame is always sent, even black: after a reset of the board
+	// only (e.g. opening the serial monitor) the pixel keeps its old color
+	luci.showColor(0, 0, 0);
+	Serial.print("First frame sent: ");
+	Serial.println(luci.getNeoPixelFramesSent() == 1 ? "OK" : "FAILED");
+	// start-up sequence: beep + Luci color breathing
+	luci.beep(EB_BEEP_DEFAULT, 100);
+	luci.breatheColor(50, 0, 20, 3000); // purple, forever
+}  // setup()
+
+void loop()
+{
+	uint32_t currentTime = millis();
+
+	// advance the effect in play (if any)
+	if (! luci.handleNeoPixel(currentTime))
+		luci.breatheColor(50, 0, 20, 3000); // back to idle
+
+	uint8_t code = luci.handleKeypad(currentTime);
+	if (! code) return;  // nothing to process
+
+	uint8_t key = code & B1111; // low nibble
+	uint8_t event = code >> 4;  // high nibble
+
+	uint8_t R = 0, G = 0, B = 0;
+	switch (key) {
+	case EB_KP_KEY_FW: B = 50; break;                   // blue
+	case EB_KP_KEY_TL: R = 50; break;                   // red
+	case EB_KP_KEY_TR: G = 50; break;                   // green
+	case EB_KP_KEY_BW: R = 50; G = 50; break;           // yellow
+	case EB_KP_KEY_GO: R = 50; G = 50; B = 50; break;   // white
+	}  // switch()
+
+	if (event == EB_KP_EVT_PRESSED)
+		luci.fadeToColor(R, G, B, 300);
+	else if (event == EB_KP_EVT_RELEASED)
+		luci.breatheColor(R, G, B, 500, 2); // two pulses
+}  // loop()
@@ -0,0 +1,41 @@
+/**
+ * Escornabot-lib remote control example: binary protocol
+ *
+ * A remote app can move the robot (any distance or angle), play sounds, show
+ * colors, query its status and change its configuration with binary frames
+ * (see EB_RM_SYNC in Escornabot-lib.h), every one acknowledged:
+ *
+ *   A5 00 01 00 15            PING (SEQ 1) -> A5 01 01 80 00 CRC
+ *   A5 03 02 01 01 64 00 63   MOVE (SEQ 2) forward 100mm -> ACK, and DONE later
+ *
+ * The single characters of handleSerial() (n, w, g, e, s...) still work.
+ *
+ * A telemetry frame (EB_RM_OP_TELEMETRY) with the robot state is sent every
+ * second too, without ever blocking the loop().
+ */
+
+#include <Escornabot-lib.h>
+Escornabot luci; // create Escornabot object
+
+void setup()
+{
+	// setup luci
+	luci.init(); // 9600 baudrate
+	// start-up sequence: beep + Luci color
+	luci.beep(EB_BEEP_DEFAULT, 100);
+	luci.showColor(50, 0, 20); // purple
+	// no banner: the Serial port is for the remote app
+	luci.startKeypadSampler(); // battery voltage is read in the background (EB_KEYPAD_SAMPLER in Config.h)
+	luci.startTelemetry(1000);
+}  // setup()
+
+void loop()
+{
+	uint32_t currentTime = millis(); // get time
+	// frames are processed (and replied) inside, motion included
+	uint8_t code = luci.handleRemote(currentTime);
+	luci.handleTelemetry(currentTime);
+
+	// legacy characters
+	if ((code >> 4) == EB_KP_EVT_RELEASED) luci.showKeyColor((EB_T_KP_KEYS)(code & B1111));
+}  // loop()
@@ -0,0 +1,47 @@
+/**
+ * Escornabot-lib stepper melody example: the steppers as the sound source
+ *
+ * The stepper motors make an audible tone at their stepping frequency, so
+ * they can also play music: each note sets the stepping frequency while the
+ * direction alternates to keep the robot roughly in place.
+ *
+ * Playing a melody is an asynchronous action like any other movement:
+ *   1. Prepare the melody beforehand with prepareMelody()
+ *   2. Call the action handler repeatedly (in the loop())
+ */
+
+#include <Escornabot-lib.h>
+Escornabot luci; // create Escornabot object
+
+// NOTE: on-line player at https://adamonsoon.github.io/rtttl-play/
+const char *song = "furelisa:d=8,o=5,b=125:e6,d#6,e6,d#6,e6,b,d6,c6,4a,";
+
+void setup()
+{
+	// setup luci
+	luci.init(); // 9600 baudrate
+	// banner
+	Serial.println("Escornalib stepper melody test for Luci");
+	// start-up sequence: beep + Luci color
+	luci.beep(EB_BEEP_DEFAULT, 100);
+	luci.showColor(50, 0, 20); // purple
+	delay(1000);
+
+	// prepare the melody
+	luci.prepareMelody(song);
+}  // setup()
+
+void loop()
+{
+	uint32_t currentTime = millis();
+
+	// attend current melody (command is ignored while playing)
+	uint8_t result = luci.handleAction(currentTime, EB_CMD_NN);
+
+	if (result == EB_CMD_R_FINISHED_ACTION)
+	{
+		delay(2000);  // <-- NOTE: during this period, everything is blocked!
+		// play it again
+		luci.prepareMelody(song);
+	}
+}  // loop()
@@ -24,7 +24,7 @@ void loop()
 	// get pressed key
 	EB_T_KP_KEYS key = luci.getPressedKey();
 	// print name
-	Serial.println(EB_KP_KEYS_LABELS[key]);
+	Serial.println(luci.getKeyLabel(key));
 	// give it some room (as "debouncing")
 	delay(200);
 }  // loop()
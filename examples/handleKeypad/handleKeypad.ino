@@ -19,6 +19,12 @@ void setup()
 	// start-up sequence: beep + Luci color
 	luci.beep(EB_BEEP_DEFAULT, 100);
 	luci.showColor(50, 0, 20); // purple
+	// (optional) sample the keypad in the background, loop() won't wait for the ADC
+	// (EB_KEYPAD_SAMPLER must be defined in Config.h, else it does nothing)
+	luci.startKeypadSampler();
+	luci.setKeypadFilter(EB_KP_FILTER_MEDIAN, 5); // noisy keypad? filter the samples
+	// (optional) double clicks within 300ms, repeat every 200ms after 600ms held
+	luci.setKeypadTimings(EB_KP_DB_TIME, EB_KP_LP_MIN_DURATION, 300, 600, 200);
 }  // setup()
 
 void loop()
@@ -32,7 +38,7 @@ void loop()
 	uint8_t event = code >> 4;  // high nibble
 
 	Serial.print("KEY: [");
-	Serial.print(EB_KP_KEYS_LABELS[key]);
+	Serial.print(luci.getKeyLabel(key));
 	Serial.print("]  EVENT: ");
 
 	switch (event) {
@@ -48,6 +54,12 @@ void loop()
 	case 4:
 		Serial.println("LONGRELEASED");
 		break;
+	case 5:
+		Serial.println("DOUBLECLICK");
+		break;
+	case 6:
+		Serial.println("REPEAT");
+		break;
 	default:
 		Serial.println("UNKNOWN"); // shouldn't happen!
 	}  // switch()
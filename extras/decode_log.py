@@ -0,0 +1,146 @@
+#!/usr/bin/env python3
+"""
+Escornabot-lib binary debug log decoder.
+
+Turns the EB_RM_OP_LOG frames sent by a library built with EB_DEBUG_MODE
+(see logEvent() and flushDebugLog()) back into text. Other bytes (text,
+other frames) are ignored.
+
+The events of the sketch (from EB_LOG_USER) are named after its #defines,
+read from the file given with --events (the .ino or a header):
+
+    #define LOG_ADDED (EB_LOG_USER + 0)  // a = command, b = ...
+
+Usage:
+    python3 decode_log.py /dev/ttyUSB0 [baudrate]   (needs pyserial)
+    python3 decode_log.py capture.bin
+    cat capture.bin | python3 decode_log.py -
+    python3 decode_log.py --events Firmware-Luci.ino /dev/ttyUSB0
+"""
+
+import argparse
+import re
+import sys
+
+SYNC = 0xA5
+OP_LOG = 0x70
+RECORD_SIZE = 7
+LOG_TIME = 0x06
+LOG_USER = 0x80
+
+COMMANDS = ["NONE", "MOVE FORWARD", "TURN LEFT", "TURN RIGHT", "MOVE BACKWARD",
+            "PAUSE", "TURN LEFT ALT", "TURN RIGHT ALT"]
+
+# id: (name, argument a, argument b), see EB_LOG_* in Escornabot-lib.h
+EVENTS = {
+    0x01: ("LOST", "records", None),
+    0x02: ("PREPARE", "command", "steps"),
+    0x03: ("POINTS", "acceleration", "deceleration"),
+    0x04: ("STOP", "pending", None),
+    0x05: ("REMOTE", "opcode", "status"),
+    0x06: ("TIME", None, None),
+}
+
+DEFINE = re.compile(r"#define\s+(?:LOG_)?(\w+)\s+\(?\s*EB_LOG_USER\s*\+\s*(\d+)\s*\)?(.*)")
+ARGUMENT = re.compile(r"\b([ab])\s*=\s*(\w+)")
+
+
+def load_events(path):
+    """Adds the events of the sketch, from its #defines, see the usage."""
+    with open(path, encoding="utf-8", errors="replace") as source:
+        for line in source:
+            match = DEFINE.search(line)
+            if not match:
+                continue
+            names = dict(ARGUMENT.findall(match.group(3)))
+            EVENTS[LOG_USER + int(match.group(2))] = (match.group(1), names.get("a"), names.get("b"))
+
+
+def crc8(data):
+    """CRC-8 CCITT (poly 0x07), as _crc8_ccitt_update() in avr-libc."""
+    crc = 0
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x07) & 0xFF if crc & 0x80 else (crc << 1) & 0xFF
+    return crc
+
+
+def frames(stream):
+    """Yields (seq, op, payload) of every valid frame in the byte stream."""
+    buffer = bytearray()
+    for chunk in stream:
+        buffer += chunk
+        while True:
+            start = buffer.find(SYNC)
+            if start < 0:
+                buffer.clear()
+                break
+            del buffer[:start]
+            if len(buffer) < 2 or len(buffer) < buffer[1] + 5:
+                break  # incomplete
+            length = buffer[1]
+            body = bytes(buffer[1:length + 4])
+            if crc8(body) == buffer[length + 4]:
+                yield body[1], body[2], body[3:]
+                del buffer[:length + 5]
+            else:
+                del buffer[:1]  # not a frame, resync
+
+
+def argument(name, value):
+    if name == "command" and 0 <= value < len(COMMANDS):
+        return "%s=%s" % (name, COMMANDS[value])
+    if name == "opcode":
+        return "%s=0x%02X" % (name, value)
+    return "%s=%d" % (name, value)
+
+
+def decode(stream):
+    last = None  # 16 bits timestamps unwrapped, resynced by the TIME records
+    offset = 0
+    for _seq, op, payload in frames(stream):
+        if op != OP_LOG:
+            continue
+        for i in range(0, len(payload) - RECORD_SIZE + 1, RECORD_SIZE):
+            record = payload[i:i + RECORD_SIZE]
+            time = record[0] | record[1] << 8
+            event = record[2]
+            a = int.from_bytes(record[3:5], "little", signed=True)
+            b = int.from_bytes(record[5:7], "little", signed=True)
+            if event == LOG_TIME:
+                offset = (a & 0xFFFF) << 16  # hi 16 bits of millis()
+            elif last is not None and time + offset < last:
+                offset += 0x10000  # wrapped (records less than 65.5s apart)
+            last = time + offset
+            if event == LOG_TIME:
+                continue
+            name, name_a, name_b = EVENTS.get(event, ("EVENT 0x%02X" % event, "a", "b"))
+            text = [argument(n, v) for n, v in ((name_a, a), (name_b, b)) if n]
+            print("%10d ms  %-10s %s" % (last, name, " ".join(text)), flush=True)
+
+
+def open_stream(source, baudrate):
+    """Yields the bytes received (serial port) or read (file, stdin)."""
+    if source.startswith("/dev/") or source.upper().startswith("COM"):
+        import serial  # pyserial
+        port = serial.Serial(source, baudrate, timeout=0.1)
+        while True:
+            yield port.read(64)
+    stream = sys.stdin.buffer if source == "-" else open(source, "rb")
+    while True:
+        chunk = stream.read(64)
+        if not chunk:
+            return
+        yield chunk
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="serial port, file, or - (stdin)")
+    parser.add_argument("baudrate", nargs="?", type=int, default=9600)
+    parser.add_argument("--events", help="sketch file with the EB_LOG_USER #defines")
+    args = parser.parse_args()
+    if args.events:
+        load_events(args.events)
+    decode(open_stream(args.source, args.baudrate))
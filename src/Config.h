@@ -36,6 +36,9 @@ const uint8_t EB_SM_DRIVING_SEQUENCE[] = {B0011, B0110, B1100, B1001};  // full
 #define STEPPERS_STEPS_MM float(STEPPERMOTOR_FULLREVOLUTION_STEPS / WHEEL_CIRCUMFERENCE) // how many steps to move 1 mm
 #define STEPPERS_STEPS_DEG float((ROTATION_CIRCUMFERENCE/360) * STEPPERS_STEPS_MM) // how many steps to rotate 1 degree
 
+// Steppers melody
+//#define EB_MELODY_TIMER1  // notes stepped by the Timer1 interrupt (takes its vector: no Servo, TimerOne...), else by handleAction()
+
 // Buzzer
 #define BUZZER_PIN 2 // 10 for the Brivoi
 
@@ -47,21 +50,66 @@ const uint8_t EB_SM_DRIVING_SEQUENCE[] = {B0011, B0110, B1100, B1001};  // full
 #define EB_KP_VALUE_TR 532
 #define EB_KP_VALUE_BW 462
 #define EB_KP_VALUE_NN 1023
+#define EB_KP_VALUE_MARGIN 0   // max distance from a key value to be accepted, 0 = no limit (e.g. 50, see setKeypadMargin())
 // advanced
 #define EB_KP_LP_MIN_DURATION 900L   // long press minimum duration, ms
 #define EB_KP_DB_TIME 30L            // debouncing time, ms
+#define EB_KP_DC_MAX_INTERVAL 0      // double click max time between clicks, ms (0 = disabled)
+#define EB_KP_RP_DELAY 500           // auto-repeat start after the press, ms
+#define EB_KP_RP_INTERVAL 0          // auto-repeat interval, ms (0 = disabled)
 #define EB_KP_CHECK_MIN_INTERVAL 5L  // checking minimum interval, ms
+//#define EB_KEYPAD_SAMPLER          // background keypad sampler, see startKeypadSampler() (takes the ADC interrupt vector)
+#define EB_KP_FILTER_SIZE 7          // max samples for the keypad filter (sampler)
+#define EB_KP_WZ_TIMEOUT 10000L      // configuration wizard max time without progress, ms
+#define EB_KP_WZ_MIN_GAP 20          // configuration wizard min separation between key values
+#define EB_KP_ADAPT_SHIFT 3          // adaptive calibration: every key stroke weights 1/2^N
+#define EB_KP_ADAPT_PERSIST 10       // adaptive calibration: drift to be saved in the EEPROM
 
 // SERIAL / BLUETOOTH
 #define EB_BAUDRATE 9600
+#define EB_SR_BUDGET_BYTES 32  // max bytes processed per call to handleSerial()/handleRemote()
+#define EB_SR_BUDGET_US 1000   // max time processing them per call, us
+#define EB_SR_EVENTS_SIZE 8    // pending serial events, power of 2
+
+// Logo interpreter
+#define EB_LG_CODE_SIZE 24   // instructions compiled and pending
+#define EB_LG_TOKEN_SIZE 8   // max word/number length, chars
+#define EB_LG_DEPTH 4        // max nested REPEATs
+
+// Telemetry
+#define EB_TM_INTERVAL 500L         // default time between frames, ms
+#define EB_TM_BATTERY_PERIOD 250    // keypad samples (~ms) between battery readings (sampler only, max 255)
+#define EB_RM_MAX_PAYLOAD 70      // remote protocol: max frame payload, bytes (128 packed commands + 6)
+#define EB_RM_FRAME_TIMEOUT 100L  // remote protocol: max gap inside a frame, ms
+
+// Program runner
+#define EB_PR_CAPACITY 256     // commands, 2 per byte (even)
+#define EB_PR_START_WAIT 600   // default pause before the first command, ms
+#define EB_PS_SLOTS 4          // EEPROM slots for the saved programs (wear leveling), right below the keypad values
+//#define EB_PROGRAM_EE_READY  // programs saved by the EE_READY interrupt (takes its vector), else by handleStandby()
+                               // (then the sketch must not access the EEPROM while ProgramRunner::isSaving())
+
+// Input queue
+#define EB_IN_QUEUE_SIZE 8      // events, power of 2
+#define EB_IN_SAMPLES_SIZE 8    // keypad reading changes kept meanwhile, power of 2
+#define EB_IN_SAMPLE_DELTA 8    // min keypad reading change to be kept
+#define EB_IN_REPLAY_MAX 5000L  // max time caught up by getInputEvent(), ms
 
 // LED
 #define SIMPLELED_PIN 13
 
 // NeoPixel
 #define NEOPIXEL_PIN 12
+#define NEOPIXEL_COUNT 1  // 1 = onboard pixel only, 8-16 for an LED ring (pixel 0 pointing forward)
 #define BRIGHTNESS_LEVEL 50  // range 10-255
+#define EB_NP_SHOW_WINDOW 100L  // us needed before the next step to transmit without delaying it
+#define EB_NP_PIXEL_TIME 30L    // us to transmit every additional pixel
+#define EB_NP_FRAME_INTERVAL 20  // ms between light effect frames (50 fps)
 
 // Stand-by (default values)
 #define POWERBANK_TIMEOUT 2000    // max time without any high current demand to the powerbank
 #define INACTIVITY_TIMEOUT 30000  // max time without any Escornabot activity before "Still ON!" alert
+
+// Debug
+//#define EB_DEBUG_MODE   // binary debug log, see logEvent() and extras/decode_log.py
+#define EB_LOG_SIZE 16  // records in RAM (7 bytes each), power of 2
@@ -13,8 +13,66 @@
  */
 
 #include <Arduino.h>
+#include <util/atomic.h>
+#include <util/crc16.h>
 #include "Escornabot-lib.h"
 
+// Serial RX buffer of the core, to detect its overflows
+#ifndef SERIAL_RX_BUFFER_SIZE
+#define SERIAL_RX_BUFFER_SIZE 64
+#endif
+
+// instance in use, needed by the interrupt service routines
+static Escornabot *eb_instance = NULL;
+// program of the sketch (restored at init() and saved in the background)
+static ProgramRunner *eb_program = NULL;
+
+// labels, in flash (PROGMEM) to save RAM: one copy, no String constructors
+static const char EB_KP_LABEL_NN[] PROGMEM = "NONE";
+static const char EB_KP_LABEL_FW[] PROGMEM = "FORWARD";
+static const char EB_KP_LABEL_TL[] PROGMEM = "TURN LEFT";
+static const char EB_KP_LABEL_GO[] PROGMEM = "GO";
+static const char EB_KP_LABEL_TR[] PROGMEM = "TURN RIGHT";
+static const char EB_KP_LABEL_BW[] PROGMEM = "BACKWARD";
+static const char EB_KP_LABEL_XX[] PROGMEM = "INVALID";
+static const char EB_KP_LABEL_C0[] PROGMEM = "CHORD 0";
+static const char EB_KP_LABEL_C1[] PROGMEM = "CHORD 1";
+static const char EB_KP_LABEL_C2[] PROGMEM = "CHORD 2";
+static const char EB_KP_LABEL_C3[] PROGMEM = "CHORD 3";
+const char * const EB_KP_KEYS_LABELS_P[EB_KP_LABELS_SIZE] PROGMEM =
+{
+	EB_KP_LABEL_NN,
+	EB_KP_LABEL_FW,
+	EB_KP_LABEL_TL,
+	EB_KP_LABEL_GO,
+	EB_KP_LABEL_TR,
+	EB_KP_LABEL_BW,
+	EB_KP_LABEL_XX,
+	EB_KP_LABEL_C0,
+	EB_KP_LABEL_C1,
+	EB_KP_LABEL_C2,
+	EB_KP_LABEL_C3
+};
+
+static const char EB_CMD_LABEL_NN[] PROGMEM = "NONE";
+static const char EB_CMD_LABEL_FW[] PROGMEM = "MOVE FORWARD";
+static const char EB_CMD_LABEL_TL[] PROGMEM = "TURN LEFT";
+static const char EB_CMD_LABEL_TR[] PROGMEM = "TURN RIGHT";
+static const char EB_CMD_LABEL_BW[] PROGMEM = "MOVE BACKWARD";
+static const char EB_CMD_LABEL_PA[] PROGMEM = "PAUSE";
+static const char EB_CMD_LABEL_TL_ALT[] PROGMEM = "TURN LEFT ALT";
+static const char EB_CMD_LABEL_TR_ALT[] PROGMEM = "TURN RIGHT ALT";
+const char * const EB_CMD_LABELS_P[EB_CMD_LABELS_SIZE] PROGMEM =
+{
+	EB_CMD_LABEL_NN,
+	EB_CMD_LABEL_FW,
+	EB_CMD_LABEL_TL,
+	EB_CMD_LABEL_TR,
+	EB_CMD_LABEL_BW,
+	EB_CMD_LABEL_PA,
+	EB_CMD_LABEL_TL_ALT,
+	EB_CMD_LABEL_TR_ALT
+};
 
 
 ////////////////////////////////////////
@@ -58,6 +116,8 @@ void Escornabot::init(
 	uint8_t neopixelPin,
 	EB_T_WIRINGTYPES wiringType)
 {
+	// instance for the interrupt service routines
+	eb_instance = this;
 	// Stepper motors
 	_setSteppersWiring(wiringType);
 	(this->*_initCoilsPins)();
@@ -77,11 +137,14 @@ void Escornabot::init(
 	// Read keypad values from EEPROM (may be invalid)
 	uint16_t *eeprom_index = EB_KP_EEPROM_VALUES_INDEX;
 	int16_t eeprom_values[5];
+	uint8_t eerie = EECR & _BV(EERIE);  // program being saved: pause it meanwhile
+	EECR &= ~_BV(EERIE);
 	for (uint8_t i = 0; i < 5; i ++)
 	{
 		eeprom_values[i] = eeprom_read_word(eeprom_index);
 		eeprom_index++;
 	}
+	EECR |= eerie;
 	// Configure keypad with EEPROM values or default (from config.h) if invalid
 	configKeypad(
 		keypadPin,
@@ -94,6 +157,8 @@ void Escornabot::init(
 	);
 	// cleaning
 	clearKeypad(0);
+	// last program saved (if any)
+	if (eb_program) eb_program->restore();
 }  // init()
 
 
@@ -181,6 +246,135 @@ void Escornabot::setStepsPerDegree(float steps)
 	_steppers_steps_deg = steps;
 }  // setStepsPerDegree()
 
+/**
+ * Sets up a melody to be played [asynchronously, via handleAction()] through
+ * the stepper motors, using their coils as the sound source.
+ *
+ * Each note sets the stepping frequency, and the moving direction alternates
+ * to keep the robot roughly in place. It may be used like any other action,
+ * but the command passed to handleAction() is ignored until the melody
+ * finishes. The steps are timed by handleAction() (the pitch depends on how
+ * often it's called) or, with EB_MELODY_TIMER1 defined in Config.h, by the
+ * Timer1 interrupt, so the pitch is accurate.
+ *
+ * @param tune  A string with the tune in RTTTL format (see playRTTTL())
+ *
+ * @note With EB_MELODY_TIMER1, Timer1 is in use while the melody is being
+ *       played (i.e. no PWM in pins 9 & 10) and its interrupt vector is
+ *       taken (i.e. no Servo or TimerOne libraries).
+ */
+void Escornabot::prepareMelody(const char* tune)
+{
+	stopAction(0); // cancel any pending action
+	_melody_tune = _parseRTTTLHeader(tune);
+	_melody_balance = 0;
+	_melody_duration = 0;
+	_melody_ptime = millis(); // first note on the next handleAction() call
+}  // prepareMelody()
+
+/**
+ * Keeps the melody going: when the current note expires, the next one is loaded
+ * (into Timer1, or stepped from here). Called from handleAction() while a
+ * melody is in play.
+ *
+ * @param currentTime  Current time in milliseconds.
+ *
+ * @return  Same as handleAction().
+ */
+uint8_t Escornabot::_handleMelody(uint32_t currentTime)
+{
+	if (currentTime - _melody_ptime < _melody_duration)
+	{
+#ifndef EB_MELODY_TIMER1
+		uint32_t cTime = micros();
+		if (_exec_wait && cTime - _exec_ptime >= _exec_wait)
+		{
+			_exec_ptime += _exec_wait;
+			if (cTime - _exec_ptime >= _exec_wait) _exec_ptime = cTime; // too late, no burst
+			_stepMelody();
+		}
+#endif
+		return EB_CMD_R_PENDING_ACTION;
+	}
+
+	// next note
+	uint16_t frequency;
+	_setMelodyTimer(0); // stop stepping, also makes _melody_balance safe to read
+	_melody_tune = _parseRTTTLNote(_melody_tune, frequency, _melody_duration);
+	if (_melody_tune == NULL) return EB_CMD_R_FINISHED_ACTION;  // end of melody
+
+	// step back towards the starting point
+	_exec_drinc = (_melody_balance > 0) ? -1 : 1;
+	_exec_drinit = (_exec_drinc > 0) ? 0 : EB_SM_DRIVING_SEQUENCE_MAX;
+	_exec_wait = frequency ? 1000000UL / frequency : 0; // step interval tracks the note
+	_setMelodyTimer(frequency);
+
+	_melody_ptime = currentTime;
+	_powerbank_previousTime = currentTime; // avoid powerbank refresh
+	_inactivity_previousTime = currentTime; // avoid standby alert
+	return EB_CMD_R_PENDING_ACTION;
+}  // _handleMelody()
+
+/**
+ * Configures Timer1 to produce one step (interrupt) per cycle of the
+ * provided frequency, in CTC mode with a /8 prescaler. Without
+ * EB_MELODY_TIMER1, it just sets the time of the first step.
+ *
+ * @param frequency  Note frequency in Hz, 0 stops the stepping (pause/silence).
+ */
+void Escornabot::_setMelodyTimer(uint16_t frequency)
+{
+#ifdef EB_MELODY_TIMER1
+	TIMSK1 &= ~_BV(OCIE1A); // stop stepping
+#endif
+	if (frequency == 0)
+	{
+		disableStepperMotors();
+		return;
+	}
+#ifdef EB_MELODY_TIMER1
+	TCCR1A = 0;
+	TCCR1B = _BV(WGM12) | _BV(CS11); // CTC mode, clk/8
+	OCR1A = (F_CPU / 8) / frequency - 1;
+	TCNT1 = 0;
+	TIMSK1 |= _BV(OCIE1A);
+#else
+	_exec_ptime = micros(); // every _exec_wait us, see _handleMelody()
+#endif
+}  // _setMelodyTimer()
+
+/**
+ * One step of the melody in play.
+ */
+void Escornabot::_stepMelody()
+{
+	// motors should turn in the same direction --> sequence inverted for each stepper
+	(this->*_setCoils)(
+		EB_SM_DRIVING_SEQUENCE[EB_SM_DRIVING_SEQUENCE_MAX - _exec_drindex],
+		EB_SM_DRIVING_SEQUENCE[_exec_drindex]
+	);
+	_exec_drindex += _exec_drinc;  // same rotation as in handleAction()
+	if (_exec_drindex > EB_SM_DRIVING_SEQUENCE_MAX) _exec_drindex = _exec_drinit;
+	_melody_balance += _exec_drinc;
+}  // _stepMelody()
+
+#ifdef EB_MELODY_TIMER1
+/**
+ * Timer1 compare interrupt: one step of the melody in play.
+ *
+ * @note Internal use only, it's public to be reachable from the ISR.
+ */
+void Escornabot::_isrTimer1()
+{
+	_stepMelody();
+}  // _isrTimer1()
+
+ISR(TIMER1_COMPA_vect)
+{
+	if (eb_instance) eb_instance->_isrTimer1();
+}
+#endif
+
 
 
 //
@@ -339,33 +533,55 @@ const uint16_t EB_NOTES_FREQUENCIES[] = // 12 notes, 4 octaves (4 to 7)
  * @note More info about the RTTTL format here: https://github.com/ArminJo/PlayRtttl/#rtttl-format
  */
 void Escornabot::playRTTTL(const char* tune)
+{
+	uint16_t frequency, duration;
+	tune = _parseRTTTLHeader(tune);
+	while ((tune = _parseRTTTLNote(tune, frequency, duration)) != NULL)
+	{
+		if (frequency) tone(_buzzer_pin, frequency);
+		delay(duration);
+		noTone(_buzzer_pin);
+	}
+}  // playRTTTL()
+
+/**
+ * Parses the name and the default parameters sections of an RTTTL tune.
+ *
+ * The defaults are kept internally, to be used by _parseRTTTLNote().
+ *
+ * @param tune  A string with the tune in RTTTL format
+ *
+ * @return  pointer to the beginning of the list of notes
+ */
+const char* Escornabot::_parseRTTTLHeader(const char* tune)
 {
 	// song name - discarded
 	while (*tune && *tune != ':') tune++;
 	tune++;
 
 	// default tune parameters
-	uint8_t default_octave = 5;
-	uint16_t default_duration= 16, bpm = 320;
+	_rtttl_octave = 5;
+	_rtttl_duration = 16;
+	_rtttl_bpm = 320;
 	while (*tune && (*tune != ':'))
 	{
 		switch (*tune)
 		{
 		case 'd': // note duration
 			tune += 2; // skip 'd='
-			default_duration = atoi(tune);
+			_rtttl_duration = atoi(tune);
 			while (*tune >= '0' && *tune <= '9') tune++; // discard used numbers
 			break;
 
 		case 'o': // octave
 			tune += 2; // skip 'o='
-			default_octave = atoi(tune);
+			_rtttl_octave = atoi(tune);
 			while (*tune >= '0' && *tune <= '9') tune++; // discard used numbers
 			break;
 
 		case 'b': // beats per minute
 			tune += 2; // skip 'b='
-			bpm = atoi(tune);
+			_rtttl_bpm = atoi(tune);
 			while (*tune >= '0' && *tune <= '9') tune++; // discard used numbers
 			break;
 
@@ -373,18 +589,31 @@ void Escornabot::playRTTTL(const char* tune)
 			tune++; // discard invalid character
 		}
 	}
-	tune++; // discard ':'
+	return ++tune; // discard ':'
+}  // _parseRTTTLHeader()
 
-	// list of notes
-	uint16_t duration = default_duration;
+/**
+ * Parses the next valid note from the list of notes of an RTTTL tune.
+ *
+ * @param tune       Pointer to the next note, as returned by _parseRTTTLHeader()
+ *                   or a previous call to this method.
+ * @param frequency  [out] Frequency of the note in Hz (0 for a pause)
+ * @param duration   [out] Duration of the note in milliseconds
+ *
+ * @return  pointer to the note following the parsed one, or NULL if there are
+ *          no more notes (outputs are not valid then).
+ */
+const char* Escornabot::_parseRTTTLNote(const char* tune, uint16_t &frequency, uint16_t &duration)
+{
+	uint16_t note_duration = _rtttl_duration;
 	int8_t note = -1;
-	uint8_t octave = default_octave;
+	uint8_t octave = _rtttl_octave;
 	while (*tune)
 	{
 		if (*tune >= '0' && *tune <= '9')
 		{
 			// consume numbers
-			if (note < 0) duration = atoi(tune);
+			if (note < 0) note_duration = atoi(tune);
 			else octave = atoi(tune);
 			while (*tune >= '0' && *tune <= '9') tune++; // discard used numbers
 		}
@@ -403,24 +632,26 @@ void Escornabot::playRTTTL(const char* tune)
 				case 'a': note = 10; break;
 				case 'b': note = 12; break;
 				case '#': note++; break;
-				case ',': case '\0':
+				case ',':
 					if (note != -1 && octave >= 4 && octave <= 8) {
+						frequency = 0;
 						if (note > 0)
-							tone(_buzzer_pin, EB_NOTES_FREQUENCIES[((octave - 4) * 12) + note - 1]);
-						delay(1000 * 60 / bpm / duration * 4); // BPM usually expresses the number of quarter notes per minute
+							frequency = EB_NOTES_FREQUENCIES[((octave - 4) * 12) + note - 1];
+						duration = 60000U / _rtttl_bpm / note_duration * 4; // BPM usually expresses the number of quarter notes per minute
 						// see https://github.com/ArminJo/PlayRtttl/blob/master/src/PlayRtttl.hpp#L192
-						noTone(_buzzer_pin);
+						return ++tune; // next
 					}
 
-					duration = default_duration;
+					note_duration = _rtttl_duration;
 					note = -1;
-					octave = default_octave;
+					octave = _rtttl_octave;
 					break;
 			}
 			tune++; // next
 		}
 	}
-}  // playRTTTL()
+	return NULL; // no more notes
+}  // _parseRTTTLNote()
 
 
 
@@ -437,6 +668,7 @@ void Escornabot::playRTTTL(const char* tune)
  */
 void Escornabot::turnLED(uint8_t state)
 {
+	stopLEDPattern();
 	digitalWrite(SIMPLELED_PIN, state);
 }  // turnLED()
 
@@ -448,6 +680,7 @@ void Escornabot::turnLED(uint8_t state)
  */
 void Escornabot::blinkLED(uint8_t times, bool reversed = false)
 {
+	stopLEDPattern();
 	while (times > 0)
 	{
 		digitalWrite(SIMPLELED_PIN, ! reversed);
@@ -458,6 +691,62 @@ void Escornabot::blinkLED(uint8_t times, bool reversed = false)
 	}
 }  // blinkLED()
 
+/**
+ * Starts blinking the Escornabot LED following the provided pattern
+ * [asynchronously, via handleLED()].
+ *
+ * @param pattern   On/off durations and number of blinks (0 = forever).
+ * @param reversed  Starts with off and ends with on.
+ *
+ * @note Calling turnLED() or blinkLED() stops the pattern in play.
+ */
+void Escornabot::startLEDPattern(EB_T_LED_PATTERN pattern, bool reversed)
+{
+	_led_pattern = pattern;
+	_led_blinks = pattern.times ? pattern.times : 1;
+	_led_reversed = reversed;
+	_led_lit = true;
+	_led_ptime = millis();
+	digitalWrite(SIMPLELED_PIN, ! reversed);
+}  // startLEDPattern()
+
+/**
+ * Stops the LED pattern in play (if any), leaving the LED as it is.
+ */
+void Escornabot::stopLEDPattern()
+{
+	_led_blinks = 0;
+}  // stopLEDPattern()
+
+/**
+ * Function responsible for advancing the LED pattern in play. This function
+ * should be called in the loop() as often as possible.
+ *
+ * @param currentTime  Current time in milliseconds (should be provided).
+ *
+ * @return  true while the pattern is in play, false otherwise.
+ */
+bool Escornabot::handleLED(uint32_t currentTime)
+{
+	if (_led_blinks == 0) return false; // nothing to do
+
+	if (_led_lit)
+	{
+		if (currentTime - _led_ptime < _led_pattern.on_time) return true;
+		digitalWrite(SIMPLELED_PIN, _led_reversed);
+	}
+	else
+	{
+		if (currentTime - _led_ptime < _led_pattern.off_time) return true;
+		if (_led_pattern.times) _led_blinks--; // forever otherwise
+		if (_led_blinks == 0) return false; // finished
+		digitalWrite(SIMPLELED_PIN, ! _led_reversed);
+	}
+	_led_lit = ! _led_lit;
+	_led_ptime = currentTime;
+	return true;
+}  // handleLED()
+
 
 
 ////////////////////////////////////////
@@ -467,7 +756,13 @@ void Escornabot::blinkLED(uint8_t times, bool reversed = false)
 ////////////////////////////////////////
 
 /**
- * Shows the provided color in the Escornabot NeoPixel.
+ * Shows the provided color in the Escornabot NeoPixel, stopping the light
+ * effect in play (if any).
+ *
+ * The transmission is skipped if the color is the one already shown, as it
+ * blocks the interrupts for the whole transfer. While an action is in
+ * progress, it may also be deferred until the next step is done (see
+ * _showNeoPixel()).
  *
  * @param R  (0-255) Ammount of red
  * @param G  (0-255) Ammount of green
@@ -475,8 +770,8 @@ void Escornabot::blinkLED(uint8_t times, bool reversed = false)
  */
 void Escornabot::showColor(uint8_t R, uint8_t G, uint8_t B)
 {
-	_neopixel->setPixelColor(0, _neopixel->Color(R, G, B));
-	_neopixel->show();
+	stopLightEffect();
+	_paintNeoPixel(_neopixel.Color(R, G, B));
 }  // showColor()
 
 /**
@@ -505,17 +800,273 @@ void Escornabot::showKeyColor(EB_T_KP_KEYS key)
 		break;
 	case EB_KP_KEY_BW:  // BW
 		showColor(BRIGHTNESS_LEVEL, BRIGHTNESS_LEVEL, 0);  // yellow
+		break;
+	case EB_KP_KEY_XX:  // INVALID
+		break;  // unchanged
 	}
 }  // showKeyColor()
 
+/**
+ * Shows the provided color in one of the NeoPixels of the ring (the rest
+ * keep their colors), stopping the light effect in play (if any).
+ *
+ * @param n  (0 to NEOPIXEL_COUNT-1) Pixel index, 0 pointing forward
+ * @param R  (0-255) Ammount of red
+ * @param G  (0-255) Ammount of green
+ * @param B  (0-255) Ammount of blue
+ */
+void Escornabot::showPixelColor(uint8_t n, uint8_t R, uint8_t G, uint8_t B)
+{
+	stopLightEffect();
+	_neopixel.setPixelColor(n, R, G, B);
+	_flushNeoPixel();
+}  // showPixelColor()
+
+/**
+ * Shows a heading in the NeoPixel ring: only the pixel closest to it is lit,
+ * with the provided color. Pixel 0 points forward and the indexes increase
+ * clockwise. With a single NeoPixel, it just shows the color.
+ *
+ * @param degrees  Heading, clockwise from forward (e.g. -90 = left)
+ * @param R  (0-255) Ammount of red
+ * @param G  (0-255) Ammount of green
+ * @param B  (0-255) Ammount of blue
+ */
+void Escornabot::showHeading(int16_t degrees, uint8_t R, uint8_t G, uint8_t B)
+{
+	stopLightEffect();
+	int16_t d = degrees % 360;
+	if (d < 0) d += 360;
+	uint8_t n = ((uint32_t)d * NEOPIXEL_COUNT + 180) / 360 % NEOPIXEL_COUNT;
+	_neopixel.fill(0);
+	_neopixel.setPixelColor(n, R, G, B);
+	_flushNeoPixel();
+}  // showHeading()
+
+/**
+ * Sets the global brightness of the NeoPixel, applied on top of the colors
+ * when transmitting them (those are kept untouched), e.g. to dim it on low
+ * battery. The color being shown is transmitted again with the new level.
+ *
+ * @param level  (0-255) Brightness, 255 (full) by default
+ */
+void Escornabot::setBrightness(uint8_t level)
+{
+	if (level == _neopixel.getBrightness()) return;
+	_neopixel.setBrightness(level);
+	_showNeoPixel();
+}  // setBrightness()
+
+/**
+ * Enables/disables the gamma correction of the NeoPixel colors, applied when
+ * transmitting them, so intermediate levels look perceptually linear.
+ * The color being shown is transmitted again.
+ *
+ * @param enabled  true to apply the gamma correction (disabled by default)
+ */
+void Escornabot::setGamma(bool enabled)
+{
+	_neopixel.setGamma(enabled);
+	_showNeoPixel();
+}  // setGamma()
+
+/**
+ * Starts a linear transition from the color being shown to the provided one
+ * [asynchronously, via handleNeoPixel()].
+ *
+ * @param R  (0-255) Ammount of red
+ * @param G  (0-255) Ammount of green
+ * @param B  (0-255) Ammount of blue
+ * @param duration  Transition time in milliseconds.
+ *
+ * @note Calling showColor() or showKeyColor() stops the effect in play.
+ */
+void Escornabot::fadeToColor(uint8_t R, uint8_t G, uint8_t B, uint16_t duration)
+{
+	_effect = EB_NP_EFFECT_FADE;
+	_effect_from = _neopixel.getPixelColor(0);
+	_effect_to = _neopixel.Color(R, G, B);
+	_effect_duration = duration ? duration : 1;
+	_effect_stime = millis();
+	_effect_ftime = _effect_stime - EB_NP_FRAME_INTERVAL; // first frame ASAP
+}  // fadeToColor()
+
+/**
+ * Starts "breathing" the provided color: smooth on/off cycles following a
+ * (gamma corrected) sine wave, starting and ending with off
+ * [asynchronously, via handleNeoPixel()]. One cycle makes a pulse.
+ *
+ * @param R  (0-255) Ammount of red
+ * @param G  (0-255) Ammount of green
+ * @param B  (0-255) Ammount of blue
+ * @param period  Duration of every cycle in milliseconds.
+ * @param times   Number of cycles, 0 = forever.
+ *
+ * @note Calling showColor() or showKeyColor() stops the effect in play.
+ */
+void Escornabot::breatheColor(uint8_t R, uint8_t G, uint8_t B, uint16_t period, uint8_t times)
+{
+	_effect = EB_NP_EFFECT_BREATHE;
+	_effect_to = _neopixel.Color(R, G, B);
+	_effect_duration = period ? period : 1;
+	_effect_times = times;
+	_effect_stime = millis();
+	_effect_ftime = _effect_stime - EB_NP_FRAME_INTERVAL; // first frame ASAP
+}  // breatheColor()
+
+/**
+ * Stops the light effect in play (if any), leaving the NeoPixel as it is.
+ */
+void Escornabot::stopLightEffect()
+{
+	_effect = EB_NP_EFFECT_NONE;
+}  // stopLightEffect()
+
+/**
+ * Function responsible for advancing the light effect in play. This function
+ * should be called in the loop() as often as possible: a new frame is only
+ * computed and transmitted every EB_NP_FRAME_INTERVAL milliseconds.
+ *
+ * @param currentTime  Current time in milliseconds (should be provided).
+ *
+ * @return  true while the effect is in play, false otherwise.
+ */
+bool Escornabot::handleNeoPixel(uint32_t currentTime)
+{
+	if (_effect == EB_NP_EFFECT_NONE) return false; // nothing to do
+	if (currentTime - _effect_ftime < EB_NP_FRAME_INTERVAL) return true; // not yet
+	_effect_ftime = currentTime;
+
+	uint32_t elapsed = currentTime - _effect_stime;
+	uint32_t color;
+	if (_effect == EB_NP_EFFECT_FADE)
+	{
+		if (elapsed >= _effect_duration)
+		{
+			color = _effect_to;
+			_effect = EB_NP_EFFECT_NONE; // finished
+		}
+		else color = _blendColor(_effect_from, _effect_to, (elapsed << 8) / _effect_duration);
+	}
+	else  // EB_NP_EFFECT_BREATHE
+	{
+		if (_effect_times && elapsed >= (uint32_t)_effect_duration * _effect_times)
+		{
+			color = 0; // off
+			_effect = EB_NP_EFFECT_NONE; // finished
+		}
+		else
+		{
+			// sine8() phase 192 is the minimum: start and end every cycle off
+			uint8_t phase = ((elapsed % _effect_duration) << 8) / _effect_duration;
+			uint8_t level = NeoPixel::gamma8(NeoPixel::sine8(phase + 192));
+			color = _blendColor(0, _effect_to, level + (level >> 7)); // 255 -> 256
+		}
+	}
+	_paintNeoPixel(color);
+	return _effect != EB_NP_EFFECT_NONE;
+}  // handleNeoPixel()
+
+/**
+ * Returns the number of frames transmitted to the NeoPixel.
+ *
+ * @return  frames transmitted since init()
+ */
+uint32_t Escornabot::getNeoPixelFramesSent()
+{
+	return _neopixel_sent;
+}  // getNeoPixelFramesSent()
+
+/**
+ * Returns the number of frames not transmitted to the NeoPixel, as they
+ * were equal to the one already shown.
+ *
+ * @return  frames skipped since init()
+ */
+uint32_t Escornabot::getNeoPixelFramesSkipped()
+{
+	return _neopixel_skipped;
+}  // getNeoPixelFramesSkipped()
+
+/**
+ * Transmits the NeoPixel frame if it can't delay the next step of the action
+ * in progress (if any), otherwise it's left pending: handleAction() sends it
+ * right after the next step, the widest window available.
+ */
+void Escornabot::_showNeoPixel()
+{
+	if (_exec_steps && ! _melody_tune)
+	{
+		uint32_t elapsed = micros() - _exec_ptime;
+		if (
+			(elapsed + EB_NP_SHOW_WINDOW + EB_NP_PIXEL_TIME * (NEOPIXEL_COUNT - 1) > _exec_wait)  // next step too close
+			|| ! _neopixel.canShow()                   // would wait for the latch
+		)
+		{
+			_neopixel_pending = true;
+			return;
+		}
+	}
+	if (_neopixel.isDirty()) _neopixel_sent++;
+	_neopixel.show();
+	_neopixel_pending = false;
+}  // _showNeoPixel()
+
+/**
+ * Sets the color of all the NeoPixels, transmitting them only if changed.
+ *
+ * @param color  Packed RGB color.
+ */
+void Escornabot::_paintNeoPixel(uint32_t color)
+{
+	_neopixel.fill(color);
+	_flushNeoPixel();
+}  // _paintNeoPixel()
+
+/**
+ * Transmits the NeoPixels changed since the last frame, if any.
+ */
+void Escornabot::_flushNeoPixel()
+{
+	if (! _neopixel.isDirty())
+	{
+		_neopixel_skipped++; // nothing changed
+		return;
+	}
+	_showNeoPixel();
+}  // _flushNeoPixel()
+
+/**
+ * Linear interpolation between two colors, channel by channel, using
+ * integer math only.
+ *
+ * @param from    Packed RGB color at amount 0.
+ * @param to      Packed RGB color at amount 256.
+ * @param amount  (0-256) Position between both colors.
+ *
+ * @return  Packed RGB color.
+ */
+uint32_t Escornabot::_blendColor(uint32_t from, uint32_t to, uint16_t amount)
+{
+	uint32_t color = 0;
+	for (uint8_t shift = 0; shift < 24; shift += 8)
+	{
+		uint16_t a = (uint8_t)(from >> shift);
+		uint16_t b = (uint8_t)(to >> shift);
+		uint16_t c = (a * (256 - amount) + b * amount) >> 8;
+		color |= (uint32_t)c << shift;
+	}
+	return color;
+}  // _blendColor()
+
 /**
  * Escornabot NeoPixel initialization.
  */
 void Escornabot::_initNeoPixel(int pin)
 {
-	// initializes our ONE pixel strip
-	_neopixel = new NeoPixel(1, pin, NEO_GRB + NEO_KHZ800);
-	_neopixel->begin();
+	// initializes our pixel strip/ring (statically allocated)
+	_neopixel.setPin(pin);
+	_neopixel.begin();
 }  // _initNeoPixel()
 
 
@@ -527,72 +1078,163 @@ void Escornabot::_initNeoPixel(int pin)
 ////////////////////////////////////////
 
 /**
- * If any key is pressed when calling this function, a configuration procedure
- * is started:
+ * If any key is pressed when calling this function, the keypad configuration
+ * wizard is run (see startKeypadWizard()) until it finishes or times out.
  *
- * 1. an alert of four beeps is sounded
- * 2. waits until no key is pressed anymore (if any, after the four beeps)
- * 3. waits for the user to press all the keys in the following order:
- *    FW, TL, GO, TR, BW (from top to bottom, from left to right)
- * 3. updates all five key values in the EEPROM (if different)
- * 
  * @param keypadPin  the analog pin to which the keypad is connected
  */
 void Escornabot::autoConfigKeypad(uint8_t keypadPin)
 {
 	// detect key pressed to start
-	pinMode(keypadPin, INPUT_PULLUP); // if not "pullupable" works as normal INPUT
-	bool press_detected = false;
-	uint16_t port_read_value = analogRead(keypadPin);
-	if (
-		(port_read_value > EB_KP_PULLUP_MARGIN)
-		&& (port_read_value < (1023 - EB_KP_PULLUP_MARGIN))
-	)
-	{
-		// something is pressed
-		for (byte i=0; i < 4; i++)
+	_keypad_pin = keypadPin;
+	pinMode(_keypad_pin, INPUT_PULLUP); // if not "pullupable" works as normal INPUT
+	if (! _isKeypadPressed(rawKeypad())) return; // exit
+
+	startKeypadWizard();
+	while (handleKeypadWizard(millis()) == EB_KP_WZ_R_RUNNING);
+}  // autoConfigKeypad()
+
+/**
+ * Starts the keypad configuration wizard [asynchronously, via
+ * handleKeypadWizard()]:
+ *
+ * 1. an alert of four beeps is sounded
+ * 2. waits until no key is pressed anymore
+ * 3. waits for the user to press (and release) all the keys in the
+ *    following order: FW, TL, GO, TR, BW (from top to bottom, from left to
+ *    right), with a beep for each one
+ * 4. validates the values: once sorted, they must be separated at least
+ *    EB_KP_WZ_MIN_GAP from each other
+ * 5. updates all five key values in the EEPROM (if different) and starts
+ *    using them
+ *
+ * The wizard is cancelled, with nothing stored, if no progress is made for
+ * EB_KP_WZ_TIMEOUT milliseconds. While it runs, handleKeypad() and the input
+ * queue ignore the keypad.
+ */
+void Escornabot::startKeypadWizard()
+{
+	_wizard_state = EB_KP_WZ_S_ALERT;
+	_wizard_index = 0;
+	_wizard_ptime = millis();
+	_wizard_stime = _wizard_ptime - EB_KP_WZ_ALERT_INTERVAL; // first beep ASAP
+}  // startKeypadWizard()
+
+/**
+ * Function responsible for advancing the keypad configuration wizard. This
+ * function should be called in the loop() as often as possible.
+ *
+ * @param currentTime  Current time in milliseconds (should be provided).
+ *
+ * @return  EB_KP_WZ_R_IDLE, EB_KP_WZ_R_RUNNING, or how it finished:
+ *          EB_KP_WZ_R_SAVED, EB_KP_WZ_R_INVALID or EB_KP_WZ_R_TIMEOUT.
+ */
+uint8_t Escornabot::handleKeypadWizard(uint32_t currentTime)
+{
+	if (_wizard_state == EB_KP_WZ_S_IDLE) return EB_KP_WZ_R_IDLE;
+	if (currentTime - _wizard_ptime > EB_KP_WZ_TIMEOUT)
+	{
+		_stopKeypadWizard(currentTime);
+		return EB_KP_WZ_R_TIMEOUT;
+	}
+
+	int16_t value = rawKeypad();
+	bool pressed = _isKeypadPressed(value);
+	switch (_wizard_state)
+	{
+	case EB_KP_WZ_S_ALERT:
+		if (currentTime - _wizard_stime < EB_KP_WZ_ALERT_INTERVAL) break;
+		_wizard_stime = currentTime;
+		if (_wizard_index < 4)
 		{
 			beep(EB_BEEP_DEFAULT, 100);
-			delay(500);
+			_wizard_index++;
+			break;
+		}
+		_wizard_index = 0;
+		_wizard_state = EB_KP_WZ_S_RELEASE;
+		break;
+	case EB_KP_WZ_S_RELEASE:
+		if (pressed) break;
+		_wizard_ptime = currentTime; // progress
+		_wizard_state = EB_KP_WZ_S_PRESS;
+		break;
+	case EB_KP_WZ_S_PRESS:
+		if (! pressed) break;
+		_wizard_stime = currentTime;
+		_wizard_state = EB_KP_WZ_S_SETTLE;
+		break;
+	case EB_KP_WZ_S_SETTLE:
+		if (! pressed)
+		{
+			_wizard_state = EB_KP_WZ_S_PRESS; // bounce
+			break;
 		}
-		press_detected = true;
+		if (currentTime - _wizard_stime < _keypad_db_time) break;
+		// store value for the key + signal
+		_wizard_values[_wizard_index++] = value;
+		beep(EB_BEEP_DEFAULT, 100);
+		_wizard_ptime = currentTime; // progress
+		_wizard_state = EB_KP_WZ_S_RELEASE;
+		if (_wizard_index < 5) break;
+		// all the keys read: validate and save
+		_stopKeypadWizard(currentTime);
+		if (! _validKeypadValues(_wizard_values)) return EB_KP_WZ_R_INVALID;
+		configKeypad(
+			_keypad_pin, _keypad_values[EB_KP_KEY_NN],
+			_wizard_values[0], _wizard_values[1], _wizard_values[2],
+			_wizard_values[3], _wizard_values[4]);
+		_storeKeypadValues(_keypad_values);
+		return EB_KP_WZ_R_SAVED;
 	}
-	if (!press_detected) return; // exit
-
-	// wait until no key is pressed anymore
-	port_read_value = analogRead(keypadPin);
-	while (
-			(port_read_value > EB_KP_PULLUP_MARGIN)
-			&& (port_read_value < 1023 - EB_KP_PULLUP_MARGIN)
-		) port_read_value = analogRead(keypadPin); // wait for the release
-
-	// read and save keys' values
-	uint16_t keypad_values[5];
-	for (byte i=0; i < 5; i++)
-	{
-		// read value
-		port_read_value = analogRead(keypadPin);
-		while (
-			(port_read_value < EB_KP_PULLUP_MARGIN)
-			|| (port_read_value > 1023 - EB_KP_PULLUP_MARGIN)
-		) port_read_value = analogRead(keypadPin); // wait for a key press
+	return EB_KP_WZ_R_RUNNING;
+}  // handleKeypadWizard()
 
-		// store value for each key
-		keypad_values[i] = port_read_value;
+/**
+ * Ends the keypad configuration wizard, discarding the keys in process.
+ *
+ * @param currentTime  Current time in milliseconds.
+ */
+void Escornabot::_stopKeypadWizard(uint32_t currentTime)
+{
+	_wizard_state = EB_KP_WZ_S_IDLE;
+	clearKeypad(currentTime);
+}  // _stopKeypadWizard()
 
-		// signal + delay
-		beep(EB_BEEP_DEFAULT, 100);
-		delay(350);
-	} // for 5 keys
+/**
+ * Checks whether an analog reading of the keypad pin means a key pressed,
+ * with no previous configuration: it's far enough from both rails.
+ *
+ * @param value  Analog reading.
+ *
+ * @return  true if any key is pressed.
+ */
+bool Escornabot::_isKeypadPressed(int16_t value)
+{
+	return (value > EB_KP_PULLUP_MARGIN) && (value < 1023 - EB_KP_PULLUP_MARGIN);
+}  // _isKeypadPressed()
 
-	// write/update values in eeprom
-	uint16_t *eeprom_index = EB_KP_EEPROM_VALUES_INDEX;
-	for (uint8_t i = 0; i < 5; i ++)
+/**
+ * Checks whether the five key values (FW, TL, GO, TR, BW) can be told apart:
+ * once sorted, each one must be at least EB_KP_WZ_MIN_GAP above the previous.
+ *
+ * @param values  Five key values.
+ *
+ * @return  true if valid.
+ */
+bool Escornabot::_validKeypadValues(const int16_t *values)
+{
+	int16_t sorted[5];
+	for (uint8_t i = 0; i < 5; i++)
 	{
-		eeprom_update_word(eeprom_index, keypad_values[i]);
-		eeprom_index ++;
+		uint8_t j = i;
+		for (; j > 0 && sorted[j - 1] > values[i]; j--) sorted[j] = sorted[j - 1];
+		sorted[j] = values[i];
 	}
-}  // autoConfigKeypad()
+	for (uint8_t i = 1; i < 5; i++)
+		if (sorted[i] - sorted[i - 1] < EB_KP_WZ_MIN_GAP) return false;
+	return true;
+}  // _validKeypadValues()
 
 /**
  * Updates the keypad configuration values: analog input pin and
@@ -630,34 +1272,45 @@ void Escornabot::configKeypad(
 	else _keypad_values[4] = key_TR;
 	if (key_BW == 0x0000 || key_BW == 0xFFFF) _keypad_values[5] = EB_KP_VALUE_BW;  // default Config.h
 	else _keypad_values[5] = key_BW;
+	_computeKeypadBounds();
+	// adaptive calibration starting point
+	for (uint8_t i = 0; i < EB_T_KP_KEYS_SIZE; i++)
+	{
+		_keypad_ema[i] = _keypad_values[i] << 4;
+		_keypad_stored[i] = _keypad_values[i];
+	}
+	if (_keypad_sampling) startKeypadSampler(); // the pin may have changed
 }  // configKeypad()
 
 /**
  * Scans the keypad port and return the current active key.
  *
- * This is a low level raw function: no logic is performed.
+ * This is a low level raw function: no logic is performed. The reading is
+ * classified with a binary search over the thresholds precomputed by
+ * configKeypad(), and rejected if it's too far from the key value found
+ * (see setKeypadMargin()), e.g. a floating or half-pressed contact.
  *
- * @return the current active (closed) key. It may be none [0].
+ * @return the current active (closed) key. It may be none [0], an invalid
+ *         reading [EB_KP_KEY_XX] or a chord [EB_KP_KEY_CHORD + index].
  */
 EB_T_KP_KEYS Escornabot::getPressedKey()
 {
-	EB_T_KP_KEYS result;
-	int16_t value, diff, minor_diff;
-
-	// defaults
-	minor_diff = 1023; // MAX analog read
-	result = EB_KP_KEY_NN; // <- no key
+	int16_t value = rawKeypad();
+	_keypad_last_value = value;
+	if (! _keypad_classes) return EB_KP_KEY_NN; // not configured yet, see configKeypad()
 
-	// check buttons
-	value = rawKeypad();
-	for (uint8_t i = EB_KP_KEY_NN; i < EB_T_KP_KEYS_SIZE; i ++)
+	// band i is [_keypad_bounds[i-1], _keypad_bounds[i])
+	uint8_t lo = 0, hi = _keypad_classes - 1;
+	while (lo < hi)
 	{
-		diff = abs(_keypad_values[i] - value);
-		if (diff < minor_diff) {
-			minor_diff = diff;
-			result = i;
-		}
+		uint8_t mid = (lo + hi) / 2;
+		if (value < _keypad_bounds[mid]) hi = mid;
+		else lo = mid + 1;
 	}
+	EB_T_KP_KEYS result = (EB_T_KP_KEYS)_keypad_order[lo];
+
+	if (_keypad_margin && (uint16_t)abs(value - _keypadValue(result)) > _keypad_margin)
+		return EB_KP_KEY_XX; // out of band
 	if (result) _inactivity_previousTime = millis(); // avoid standby alert
 	return result;
 }  // getPressedKey()
@@ -674,26 +1327,53 @@ EB_T_KP_KEYS Escornabot::getPressedKey()
  * @param currentTime  Current time in milliseconds (should be provided).
  *
  * @return  lo nibble -> key [EB_T_KP_KEYS],  hi nibble -> event [EB_T_KP_EVENTS]
+ *          Always 0 with the input queue or the configuration wizard
+ *          running, see getInputEvent() and startKeypadWizard().
  */
 uint8_t Escornabot::handleKeypad(uint32_t currentTime)
+{
+	if (_input_queued) return 0; // queued, see getInputEvent()
+	if (_wizard_state) return 0; // in use by the configuration wizard
+	return _processKeypad(currentTime);
+}  // handleKeypad()
+
+/**
+ * Keypad processing engine, see handleKeypad().
+ *
+ * @param currentTime  Current time in milliseconds.
+ *
+ * @return  lo nibble -> key [EB_T_KP_KEYS],  hi nibble -> event [EB_T_KP_EVENTS]
+ */
+uint8_t Escornabot::_processKeypad(uint32_t currentTime)
 {
 	uint8_t result = 0;
 	if ((currentTime - _keypad_previousTime) > EB_KP_CHECK_MIN_INTERVAL)
 	{
 		/* Debouncing and reading */
 		if (
-			( _keypad_key_state[CURRENT] == OFF && (currentTime - _keypad_pressed_time[CURRENT]) > EB_KP_DB_TIME) // FDB - Final Debouncing
+			( _keypad_key_state[CURRENT] == OFF && (currentTime - _keypad_pressed_time[CURRENT]) > _keypad_db_time) // FDB - Final Debouncing
 			||
-			(_keypad_key_state[CURRENT] == ON && (currentTime - _keypad_pressed_time[PREVIOUS]) > EB_KP_DB_TIME) // IDB - Initial Debouncing
+			(_keypad_key_state[CURRENT] == ON && (currentTime - _keypad_pressed_time[PREVIOUS]) > _keypad_db_time) // IDB - Initial Debouncing
 		   )
 		{
 			// debouncing window correctly cleared -> let's read
-			_keypad_key[CURRENT] = getPressedKey();
-			// disallow key change
-			if (_keypad_key[CURRENT] && _keypad_key[SAVED] && (_keypad_key[CURRENT] != _keypad_key[SAVED]))
-				_keypad_key[CURRENT] = 0; // == NONE
-			// store key state
-			_keypad_key_state[CURRENT] = _keypad_key[CURRENT] ? ON : OFF; // if a key was detected, it is ON
+			uint8_t key = getPressedKey();
+			if (key != EB_KP_KEY_XX) // invalid readings are ignored: state unchanged
+			{
+				uint8_t saved = _keypad_key[SAVED];
+				if (key && saved && (key != saved))
+				{
+					// a key of the chord in process released first: still the chord
+					if (_isKeypadChordOf(saved, key)) key = saved;
+					// disallow key change, but to a chord with the key in process
+					else if (! _isKeypadChordOf(key, saved)) key = 0; // == NONE
+				}
+				_keypad_key[CURRENT] = key;
+				// reading of the key in process (adaptive calibration)
+				if (_keypad_key[CURRENT]) _keypad_press_value = _keypad_last_value;
+				// store key state
+				_keypad_key_state[CURRENT] = _keypad_key[CURRENT] ? ON : OFF; // if a key was detected, it is ON
+			}
 		}
 		/* Check state changes */
 		// pressed
@@ -702,7 +1382,29 @@ uint8_t Escornabot::handleKeypad(uint32_t currentTime)
 			_keypad_key[SAVED] = _keypad_key[CURRENT];
 			_keypad_pressed_time[PREVIOUS] = currentTime;
 			_keypad_key_state[PREVIOUS] = ON;
+			_keypad_repeat_next = currentTime + _keypad_rp_delay;
+			if (
+				_keypad_dc_time && _keypad_key[SAVED] == _keypad_click_key
+				&& (currentTime - _keypad_click_time) <= _keypad_dc_time
+			)
+			{
+				// DOUBLECLICK event
+				_keypad_click_key = EB_KP_KEY_XX; // second click in process
+				result = EB_KP_EVT_DOUBLECLICK << 4 | _keypad_key[SAVED];
+			}
 			// PRESSED event
+			else result = EB_KP_EVT_PRESSED << 4 | _keypad_key[SAVED];
+		}
+		else
+		// chord: switched from a key to a chord with it
+		if (_keypad_key_state[PREVIOUS] != OFF && _keypad_key_state[CURRENT] == ON
+			&& _keypad_key[CURRENT] != _keypad_key[SAVED])
+		{
+			_keypad_key[SAVED] = _keypad_key[CURRENT];
+			_keypad_pressed_time[PREVIOUS] = currentTime;
+			_keypad_key_state[PREVIOUS] = ON;
+			_keypad_repeat_next = currentTime + _keypad_rp_delay;
+			// PRESSED event (of the chord)
 			result = EB_KP_EVT_PRESSED << 4 | _keypad_key[SAVED];
 		}
 		else
@@ -711,13 +1413,20 @@ uint8_t Escornabot::handleKeypad(uint32_t currentTime)
 		{
 			// update pressed time
 			_keypad_pressed_time[CURRENT] = currentTime;
-			if (_keypad_pressed_time[CURRENT] - _keypad_pressed_time[PREVIOUS] > EB_KP_LP_MIN_DURATION)
+			if (_keypad_pressed_time[CURRENT] - _keypad_pressed_time[PREVIOUS] > _keypad_lp_time)
 			{
 				// button was long pressed
 				_keypad_key_state[PREVIOUS] = STALLED;
 				// LONGPRESSED event
 				result = EB_KP_EVT_LONGPRESSED << 4 | _keypad_key[SAVED];
 			}
+			else result = _repeatKeypad(currentTime);
+		}
+		else
+		// still held after a long press
+		if (_keypad_key_state[PREVIOUS] == STALLED && _keypad_key_state[CURRENT] == ON)
+		{
+			result = _repeatKeypad(currentTime);
 		}
 		else
 		// released
@@ -728,6 +1437,10 @@ uint8_t Escornabot::handleKeypad(uint32_t currentTime)
 			_keypad_key_state[PREVIOUS] = OFF;
 			// RELEASED event
 			result = EB_KP_EVT_RELEASED << 4 | _keypad_key[SAVED];
+			if (_keypad_adaptive) _adaptKeypad(_keypad_key[SAVED], _keypad_press_value);
+			// first click of a double click? (not after the second one)
+			_keypad_click_key = (_keypad_click_key == EB_KP_KEY_XX) ? (uint8_t)EB_KP_KEY_NN : _keypad_key[SAVED];
+			_keypad_click_time = currentTime;
 			// save key
 			_keypad_key[SAVED] = 0; // == NONE == _keypad_key[CURRENT];
 		}
@@ -740,119 +1453,1473 @@ uint8_t Escornabot::handleKeypad(uint32_t currentTime)
 			_keypad_key_state[PREVIOUS] = OFF;
 			// LONGRELEASED event");
 			result = EB_KP_EVT_LONGRELEASED << 4 | _keypad_key[SAVED];
+			if (_keypad_adaptive) _adaptKeypad(_keypad_key[SAVED], _keypad_press_value);
 			// save key
 			_keypad_key[SAVED] = 0; // == NONE == _keypad_key[CURRENT];
 		}
 		_keypad_previousTime = currentTime;
 	}
 	return result;
-}  // handleKeypad()
+}  // _processKeypad()
+
+/**
+ * Generates the auto-repeat events of the key held, if enabled and it's time.
+ *
+ * @param currentTime  Current time in milliseconds.
+ *
+ * @return  REPEAT event (hi nibble) of the key in process (lo nibble), or 0.
+ */
+uint8_t Escornabot::_repeatKeypad(uint32_t currentTime)
+{
+	if (! _keypad_rp_interval) return 0; // disabled
+	if ((int32_t)(currentTime - _keypad_repeat_next) < 0) return 0; // not yet
+	_keypad_repeat_next += _keypad_rp_interval;
+	return EB_KP_EVT_REPEAT << 4 | _keypad_key[SAVED];
+}  // _repeatKeypad()
+
+/**
+ * Clear all internal states of the keypad management process.
+ *
+ * @param currentTime  Current time in milliseconds (should be provided).
+ */
+void Escornabot::clearKeypad(uint32_t currentTime)
+{
+	memset(_keypad_key, 0, sizeof(_keypad_key));
+	memset(_keypad_key_state, 0, sizeof(_keypad_key_state));
+	memset(_keypad_pressed_time, 0, sizeof(_keypad_pressed_time));
+	_keypad_previousTime = currentTime;
+	_keypad_click_key = EB_KP_KEY_NN;
+}  // clearKeypad()
+
+/**
+ * Checks if the named button is being pressed.
+ *
+ * Helper function for mBlock3 extension.
+ *
+ * @param label  Name of the button to check.
+ * @return true if the button is active, false otherwise.
+ */
+bool Escornabot::isButtonPressed(String label)
+{
+	return isButtonPressed(label.c_str());
+}  // isButtonPressed()
+
+/**
+ * Checks if the named button is being pressed, no String involved.
+ *
+ * @param label  Name of the button to check (in RAM).
+ * @return true if the button is active, false otherwise.
+ */
+bool Escornabot::isButtonPressed(const char *label)
+{
+	uint8_t keyPressed = getPressedKey();
+	return strcmp_P(label, (const char *)pgm_read_ptr(&EB_KP_KEYS_LABELS_P[keyPressed])) == 0;
+}  // isButtonPressed()
+
+/**
+ * Checks if the named button is being pressed, no String involved.
+ *
+ * @param label  Name of the button to check (in flash, F("...")).
+ * @return true if the button is active, false otherwise.
+ */
+bool Escornabot::isButtonPressed(const __FlashStringHelper *label)
+{
+	uint8_t keyPressed = getPressedKey();
+	const char *a = (const char *)label;
+	const char *b = (const char *)pgm_read_ptr(&EB_KP_KEYS_LABELS_P[keyPressed]);
+	// both in flash
+	char c;
+	do
+	{
+		c = pgm_read_byte(a++);
+		if (c != (char)pgm_read_byte(b++)) return false;
+	} while (c);
+	return true;
+}  // isButtonPressed()
+
+/**
+ * Checks if the button is being pressed.
+ *
+ * @param key  Button to check.
+ * @return true if the button is active, false otherwise.
+ */
+bool Escornabot::isButtonPressed(EB_T_KP_KEYS key)
+{
+	return getPressedKey() == key;
+}  // isButtonPressed()
+
+/**
+ * Returns the name of a key, stored in flash.
+ *
+ * @param key  Key [EB_T_KP_KEYS] or chord [EB_KP_KEY_CHORD + index].
+ * @return the name, to be used with print() and the like (INVALID if unknown).
+ */
+const __FlashStringHelper *Escornabot::getKeyLabel(uint8_t key)
+{
+	if (key >= EB_KP_LABELS_SIZE) key = EB_KP_KEY_XX;
+	return (const __FlashStringHelper *)pgm_read_ptr(&EB_KP_KEYS_LABELS_P[key]);
+}  // getKeyLabel()
+
+/**
+ * Lowest level reading function of the keypad input pin.
+ *
+ * With the keypad sampler running, the latest sampled reading is returned
+ * straight away, instead of waiting for a whole conversion (~110us), and
+ * the ADC is never used directly: until the first filtered sample arrives,
+ * no key is read.
+ *
+ * @return Analog reading output of the keypad pin.
+ */
+int16_t Escornabot::rawKeypad()
+{
+	if (_input_replaying) return _input_value; // reading in force at that time
+	if (_keypad_sampling)
+	{
+		int16_t sample;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+		{
+			sample = _keypad_sample;
+		}
+		return sample >= 0 ? sample : _keypadValue(EB_KP_KEY_NN);
+	}
+	return analogRead(_keypad_pin);
+}  // rawKeypad()
+
+/**
+ * Starts sampling the keypad pin in the background: the ADC converts it
+ * automatically on every Timer0 overflow (~1ms, the millis() tick) and the
+ * conversion complete interrupt stores the reading for rawKeypad(). The
+ * battery voltage is read in between too, see getBatteryVoltage().
+ *
+ * @note While sampling, analogRead() must not be used on other pins, as it
+ *       shares the ADC. Call stopKeypadSampler() before.
+ * @note It takes the ADC interrupt vector, so it's only available with
+ *       EB_KEYPAD_SAMPLER defined in Config.h (else, it does nothing).
+ */
+void Escornabot::startKeypadSampler()
+{
+#ifdef EB_KEYPAD_SAMPLER
+	uint8_t channel = _keypad_pin;
+	if (channel >= A0) channel -= A0; // pin number to ADC channel
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_keypad_sample = -1; // none yet
+		_keypad_windex = 0;
+		_keypad_wfull = false;
+		_keypad_acc = 0;
+		_battery_phase = 0;
+		_keypad_sampling = true;
+		ADMUX = _BV(REFS0) | (channel & 0x07); // AVcc reference (DEFAULT), right adjusted
+		ADCSRB = _BV(ADTS2); // auto trigger source: Timer/Counter0 overflow
+		ADCSRA = _BV(ADEN) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE)
+			| _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0); // clk/128, as analogRead()
+	}
+#endif
+}  // startKeypadSampler()
+
+/**
+ * Stops the background sampling of the keypad pin: rawKeypad() and
+ * analogRead() work on demand again.
+ */
+void Escornabot::stopKeypadSampler()
+{
+	if (! _keypad_sampling) return;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_keypad_sampling = false;
+		_battery_mv = 0; // unknown from now on
+		ADCSRA = _BV(ADEN) | _BV(ADIF) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0); // as left by init()
+		ADCSRB = 0;
+	}
+	while (ADCSRA & _BV(ADSC)); // let any triggered conversion finish
+}  // stopKeypadSampler()
+
+/**
+ * Sets the filter applied to the keypad samples, to reject the noise of
+ * long cables without raising the debouncing time. It's computed from the
+ * sampler stream as every sample arrives, so rawKeypad() doesn't wait for
+ * it (without the sampler running, readings aren't filtered).
+ *
+ * @param filter   EB_KP_FILTER_MEDIAN (sliding window), EB_KP_FILTER_AVERAGE
+ *                 (a new reading every N samples) or EB_KP_FILTER_NONE.
+ * @param samples  (1-EB_KP_FILTER_SIZE) N, samples filtered.
+ */
+void Escornabot::setKeypadFilter(EB_T_KP_FILTERS filter, uint8_t samples)
+{
+	if (samples < 1) samples = 1;
+	if (samples > EB_KP_FILTER_SIZE) samples = EB_KP_FILTER_SIZE;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_keypad_filter = filter;
+		_keypad_filter_size = samples;
+		_keypad_windex = 0;
+		_keypad_wfull = false;
+		_keypad_acc = 0;
+	}
+}  // setKeypadFilter()
+
+#ifdef EB_KEYPAD_SAMPLER
+/**
+ * ADC conversion complete interrupt: filters and stores the keypad reading,
+ * and records its changes for the input queue. Nothing else is done here:
+ * the keypad and the Serial port are processed in the main context.
+ *
+ * @note Internal use only, it's public to be reachable from the ISR.
+ */
+void Escornabot::_isrADC()
+{
+	int16_t sample = ADC;
+	// battery (AVcc) reading, against the internal 1.1V bandgap, interleaved
+	if (_battery_phase)
+	{
+		if (_battery_phase == 2)
+		{
+			if (sample) _battery_mv = 1125300L / sample; // 1.1V * 1023 * 1000
+			ADMUX = _battery_admux; // back to the keypad
+			_battery_phase = 0;
+		}
+		else _battery_phase = 2; // first conversion discarded, bandgap settling
+		return; // not a keypad sample
+	}
+	if (++_battery_count >= EB_TM_BATTERY_PERIOD)
+	{
+		// this sample is still the keypad's; the next conversion (started by
+		// the next Timer0 overflow) reads the bandgap and is discarded while it
+		// settles, and the following one is the valid battery reading
+		_battery_count = 0;
+		_battery_phase = 1;
+		_battery_admux = ADMUX;
+		ADMUX = (ADMUX & 0xF0) | 0x0E; // MUX = 1.1V (VBG)
+	}
+	switch (_keypad_filter)
+	{
+	case EB_KP_FILTER_MEDIAN:
+	{
+		_keypad_window[_keypad_windex++] = sample;
+		if (_keypad_windex >= _keypad_filter_size)
+		{
+			_keypad_windex = 0;
+			_keypad_wfull = true;
+		}
+		if (! _keypad_wfull) break; // not enough samples yet
+		// insertion sort of a copy (a few us for up to EB_KP_FILTER_SIZE samples)
+		int16_t sorted[EB_KP_FILTER_SIZE];
+		for (uint8_t i = 0; i < _keypad_filter_size; i++)
+		{
+			uint8_t j = i;
+			for (; j > 0 && sorted[j - 1] > _keypad_window[i]; j--) sorted[j] = sorted[j - 1];
+			sorted[j] = _keypad_window[i];
+		}
+		_keypad_sample = sorted[(_keypad_filter_size - 1) / 2];
+		break;
+	}
+	case EB_KP_FILTER_AVERAGE:
+		_keypad_acc += sample;
+		if (++_keypad_windex < _keypad_filter_size) break; // not enough samples yet
+		_keypad_sample = _keypad_acc / _keypad_filter_size;
+		_keypad_windex = 0;
+		_keypad_acc = 0;
+		break;
+	default:
+		_keypad_sample = sample;
+	}
+
+	// input queue: keep the reading changes with their time, see _pumpInput()
+	sample = _keypad_sample;
+	if (_input_queued && sample >= 0 && abs(sample - _input_slast) > EB_IN_SAMPLE_DELTA)
+	{
+		uint8_t next = (_input_shead + 1) & (EB_IN_SAMPLES_SIZE - 1);
+		if (next == _input_stail) return; // full, the newest is caught up later
+		_input_samples[_input_shead].time = millis();
+		_input_samples[_input_shead].value = sample;
+		_input_slast = sample;
+		_input_shead = next;
+	}
+}  // _isrADC()
+
+ISR(ADC_vect)
+{
+	if (eb_instance) eb_instance->_isrADC();
+}
+#endif
+
+/**
+ * Returns the current keypad keys values in use.
+ *
+ * @return Array with the keypad keys values: NN, FW, TL, GO, TR, BW.
+ */
+int16_t* Escornabot::getKeypadValues()
+{
+	return _keypad_values;
+}  // getKeypadValues()
+
+/**
+ * Sets the maximum distance between an analog reading and the value of the
+ * closest key for the reading to be accepted: farther readings are invalid
+ * [EB_KP_KEY_XX], so getPressedKey() may return it. EB_KP_VALUE_MARGIN by
+ * default (0: no limit, every reading is the closest key).
+ *
+ * @param margin  maximum distance, 0 = no limit (always the closest key)
+ */
+void Escornabot::setKeypadMargin(uint16_t margin)
+{
+	_keypad_margin = margin;
+}  // setKeypadMargin()
+
+/**
+ * Sorts the keys and chords by their analog values and computes the
+ * thresholds between them (midpoints), used by getPressedKey() to classify
+ * readings.
+ */
+void Escornabot::_computeKeypadBounds()
+{
+	// insertion sort, only up to 10 keys & chords
+	_keypad_classes = 0;
+	for (uint8_t key = 0; key < EB_KP_KEY_CHORD + EB_KP_CHORDS_SIZE; key++)
+	{
+		if (key >= EB_T_KP_KEYS_SIZE && ! _keypadValue(key)) continue; // not a key/chord
+		int16_t value = _keypadValue(key);
+		uint8_t j = _keypad_classes++;
+		for (; j > 0 && _keypadValue(_keypad_order[j - 1]) > value; j--)
+			_keypad_order[j] = _keypad_order[j - 1];
+		_keypad_order[j] = key;
+	}
+	for (uint8_t i = 0; i < _keypad_classes - 1; i++)
+		_keypad_bounds[i] = (_keypadValue(_keypad_order[i]) + _keypadValue(_keypad_order[i + 1])) / 2;
+}  // _computeKeypadBounds()
+
+/**
+ * Returns the analog value of a key or a chord.
+ *
+ * @param key  Key [EB_T_KP_KEYS] or chord [EB_KP_KEY_CHORD + index].
+ *
+ * @return  analog value, 0 if none.
+ */
+int16_t Escornabot::_keypadValue(uint8_t key)
+{
+	if (key < EB_T_KP_KEYS_SIZE) return _keypad_values[key];
+	if (key >= EB_KP_KEY_CHORD && key < EB_KP_KEY_CHORD + EB_KP_CHORDS_SIZE)
+		return _keypad_chord_values[key - EB_KP_KEY_CHORD];
+	return 0;
+}  // _keypadValue()
+
+/**
+ * Checks whether a chord contains a key.
+ *
+ * @param chord  Chord [EB_KP_KEY_CHORD + index] (other keys are accepted).
+ * @param key    Key [EB_T_KP_KEYS].
+ *
+ * @return  true if the key is part of the chord.
+ */
+bool Escornabot::_isKeypadChordOf(uint8_t chord, uint8_t key)
+{
+	if (chord < EB_KP_KEY_CHORD || chord >= EB_KP_KEY_CHORD + EB_KP_CHORDS_SIZE) return false;
+	uint8_t keys = _keypad_chord_keys[chord - EB_KP_KEY_CHORD];
+	return (keys >> 4) == key || (keys & B1111) == key;
+}  // _isKeypadChordOf()
+
+/**
+ * Sets up a two-key chord: pressing both keys at the same time gives its own
+ * analog reading in the keypad resistor ladder (if the keypad allows it),
+ * reported as the key EB_KP_KEY_CHORD + index. Switching from one of the keys
+ * to the chord is allowed while held (a new PRESSED event is generated for
+ * the chord, and no RELEASED for the key).
+ *
+ * @param index  (0 to EB_KP_CHORDS_SIZE-1) Chord to set up.
+ * @param key1   First key of the chord.
+ * @param key2   Second key of the chord.
+ * @param value  Analog reading for both keys pressed, 0 removes the chord.
+ */
+void Escornabot::configKeypadChord(uint8_t index, EB_T_KP_KEYS key1, EB_T_KP_KEYS key2, int16_t value)
+{
+	if (index >= EB_KP_CHORDS_SIZE) return;
+	_keypad_chord_keys[index] = key1 << 4 | key2;
+	_keypad_chord_values[index] = value;
+	_computeKeypadBounds();
+}  // configKeypadChord()
+
+/**
+ * Sets the timings of the keypad processing, see handleKeypad().
+ *
+ * @param debounce        Debouncing time (EB_KP_DB_TIME by default).
+ * @param longPress       Long press minimum duration (EB_KP_LP_MIN_DURATION by default).
+ * @param doubleClick     Max time between the release of a key and its next press
+ *                        to be a DOUBLECLICK event, instead of PRESSED (0 = disabled).
+ * @param repeatDelay     Time after the press to start the REPEAT events.
+ * @param repeatInterval  Time between REPEAT events while the key is held (0 = disabled).
+ */
+void Escornabot::setKeypadTimings(
+	uint16_t debounce,
+	uint16_t longPress,
+	uint16_t doubleClick,
+	uint16_t repeatDelay,
+	uint16_t repeatInterval)
+{
+	_keypad_db_time = debounce;
+	_keypad_lp_time = longPress;
+	_keypad_dc_time = doubleClick;
+	_keypad_rp_delay = repeatDelay;
+	_keypad_rp_interval = repeatInterval;
+}  // setKeypadTimings()
+
+/**
+ * Enables/disables the adaptive calibration of the keypad: every confirmed
+ * key stroke moves the key value towards its reading (exponential moving
+ * average, 1/2^EB_KP_ADAPT_SHIFT of the difference), following the drift
+ * caused by temperature, battery voltage or aging. Once any value drifts
+ * EB_KP_ADAPT_PERSIST or more from the stored one, the values are saved in
+ * the EEPROM in the background by handleStandby(), when idle (one byte
+ * every time the EEPROM is ready, after any program save). Disabled by default.
+ *
+ * @param enabled  true to enable the adaptive calibration.
+ */
+void Escornabot::setKeypadAdaptive(bool enabled)
+{
+	_keypad_adaptive = enabled;
+}  // setKeypadAdaptive()
+
+/**
+ * Moves the value of a key towards a confirmed reading of it, unless that
+ * would bring it too close (EB_KP_WZ_MIN_GAP) to another key.
+ *
+ * @param key    Key confirmed.
+ * @param value  Analog reading of the key.
+ */
+void Escornabot::_adaptKeypad(uint8_t key, int16_t value)
+{
+	if (key == EB_KP_KEY_NN || key >= EB_T_KP_KEYS_SIZE) return;
+	// fixed point x16
+	uint16_t ema = _keypad_ema[key] + (((value << 4) - (int16_t)_keypad_ema[key]) >> EB_KP_ADAPT_SHIFT);
+	int16_t adapted = (ema + 8) >> 4;
+	for (uint8_t i = 0; i < EB_T_KP_KEYS_SIZE; i++)
+		if (i != key && abs(_keypad_values[i] - adapted) < EB_KP_WZ_MIN_GAP) return; // too close
+	_keypad_ema[key] = ema;
+	if (adapted == _keypad_values[key]) return;
+	_keypad_values[key] = adapted;
+	_computeKeypadBounds();
+	if (abs(adapted - _keypad_stored[key]) >= EB_KP_ADAPT_PERSIST) _keypad_drifted = true;
+}  // _adaptKeypad()
+
+/**
+ * Saves the key values in the EEPROM (only those changed). It takes ~3.4ms
+ * for every value written.
+ *
+ * @param values  Key values: NN (not stored), FW, TL, GO, TR, BW.
+ */
+void Escornabot::_storeKeypadValues(const int16_t *values)
+{
+	uint16_t *eeprom_index = EB_KP_EEPROM_VALUES_INDEX;
+	uint8_t eerie = EECR & _BV(EERIE);  // program being saved: pause it meanwhile
+	EECR &= ~_BV(EERIE);
+	for (uint8_t i = EB_KP_KEY_FW; i < EB_T_KP_KEYS_SIZE; i ++)
+	{
+		eeprom_update_word(eeprom_index, values[i]);
+		_keypad_stored[i] = values[i];
+		eeprom_index ++;
+	}
+	EECR |= eerie;
+}  // _storeKeypadValues()
+
+
+
+
+////////////////////////////////////////
+//
+// Serial / Blueetooth
+//
+////////////////////////////////////////
+
+/**
+ * Processes data comming through the Serial port and converts it into useful
+ * info, with the same format as handleKeypad().
+ *
+ * All the bytes available are processed (within the budget, see
+ * setSerialBudget()) so bursts don't overflow the RX buffer, and the events
+ * decoded are returned one per call.
+ *
+ * This is a high level management function, valid for logic control.
+ * This function should be called in the loop() as often as possible.
+ *
+ * @return  lo nibble -> key [EB_T_KP_KEYS],  hi nibble -> event [EB_T_KP_EVENTS]
+ *          Always 0 with the input queue running, see getInputEvent().
+ */
+uint8_t Escornabot::handleSerial()
+{
+	if (_input_queued) return 0; // queued, see getInputEvent()
+	_readSerial(millis(), false);
+	return _popSerial();
+}  // handleSerial()
+
+/**
+ * Sets the limits to process the bytes received in every call to
+ * handleSerial() or handleRemote(): the rest wait for the next call.
+ *
+ * @param bytes   Max bytes (EB_SR_BUDGET_BYTES by default).
+ * @param us      Max time, us (EB_SR_BUDGET_US by default).
+ */
+void Escornabot::setSerialBudget(uint8_t bytes, uint16_t us)
+{
+	_serial_budget_bytes = bytes ? bytes : 1;
+	_serial_budget_us = us;
+}  // setSerialBudget()
+
+/**
+ * Returns the number of times the RX buffer of the Serial port was found full,
+ * so bytes received may have been lost: handleSerial() or handleRemote() are
+ * not called often enough or their budget is too low.
+ *
+ * @return  overflows since init()
+ */
+uint16_t Escornabot::getSerialOverflows()
+{
+	return _serial_overflows;
+}  // getSerialOverflows()
+
+/**
+ * Returns the number of serial events lost because they were decoded faster
+ * than consumed by handleSerial() / handleRemote() calls.
+ *
+ * @return  events lost since init()
+ */
+uint16_t Escornabot::getSerialDropped()
+{
+	return _serial_dropped;
+}  // getSerialDropped()
+
+/**
+ * Processes the bytes received through the Serial port, within the budget,
+ * storing the events decoded (or pushing them into the input queue).
+ *
+ * @param currentTime  Current time in milliseconds.
+ * @param remote       Process the frames of the remote protocol too.
+ */
+void Escornabot::_readSerial(uint32_t currentTime, bool remote)
+{
+	if (Serial.available() >= SERIAL_RX_BUFFER_SIZE - 1) _serial_overflows++; // full
+	if (remote && ! _flushFrame()) return; // last reply in process, requests wait
+	uint32_t stime = micros();
+	for (uint8_t n = 0; n < _serial_budget_bytes && Serial.available(); n++)
+	{
+		if (micros() - stime > _serial_budget_us) break; // out of time
+		if (_logo_on && _logo_len > EB_LG_CODE_SIZE - 2) break; // no room, let them wait
+		uint8_t data = Serial.read();
+		if (remote)
+		{
+			_remote_btime = currentTime;
+			if (_remote_state != EB_RM_S_SYNC || data == EB_RM_SYNC)
+			{
+				if (_parseRemote(data))
+				{
+					_execRemote(currentTime);
+					if (! _flushFrame()) break; // reply in process, requests wait
+				}
+				continue;
+			}
+		}
+		if (_logo_on)
+		{
+			_parseLogo(data);
+			continue;
+		}
+		// single character
+		uint8_t code = _decodeSerial(data);
+		if (! code) continue;
+		if (_input_queued)
+		{
+			_pushInput(currentTime, code, EB_IN_SRC_SERIAL);
+			continue;
+		}
+		uint8_t next = (_serial_head + 1) & (EB_SR_EVENTS_SIZE - 1);
+		if (next == _serial_tail)
+		{
+			_serial_dropped++; // full, the newest is lost
+			continue;
+		}
+		_serial_events[_serial_head] = code;
+		_serial_head = next;
+	}
+}  // _readSerial()
+
+/**
+ * Returns the oldest serial event pending, see _readSerial().
+ *
+ * @return  event code, 0 if none.
+ */
+uint8_t Escornabot::_popSerial()
+{
+	if (_serial_tail == _serial_head) return 0; // empty
+	uint8_t code = _serial_events[_serial_tail];
+	_serial_tail = (_serial_tail + 1) & (EB_SR_EVENTS_SIZE - 1);
+	return code;
+}  // _popSerial()
+
+/**
+ * Converts a character received through the Serial port, see handleSerial().
+ *
+ * @param data  Character received (-1 = none).
+ *
+ * @return  lo nibble -> key [EB_T_KP_KEYS],  hi nibble -> event [EB_T_KP_EVENTS]
+ */
+uint8_t Escornabot::_decodeSerial(int16_t data)
+{
+	switch (data)
+	{
+	case 'n':
+		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_FW);
+		break;
+	case 'w':
+		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_TL);
+		break;
+	case 'g':
+		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_GO);
+		break;
+	case 'e':
+		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_TR);
+		break;
+	case 's':
+		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_BW);
+		break;
+	case 'N':
+		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_FW);
+		break;
+	case 'W':
+		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_TL);
+		break;
+	case 'G':
+		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_GO);
+		break;
+	case 'E':
+		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_TR);
+		break;
+	case 'S':
+		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_BW);
+		break;
+	default:
+		return 0; // just ignore it, even CR & LF
+	}
+}  // _decodeSerial()
+
+/**
+ * Processes the binary frames of the remote protocol (see EB_RM_SYNC) coming
+ * through the Serial port, replying every request with ACK/NACK, and drives
+ * the motion requested remotely (DONE is sent when finished). Characters out
+ * of a frame are processed as with handleSerial(), so both modes can be used
+ * at the same time. Only the bytes already received are processed (within
+ * the budget, see setSerialBudget()): a partial frame never blocks (and it is
+ * dropped after EB_RM_FRAME_TIMEOUT).
+ *
+ * Replies never block either: they are sent as the TX buffer makes room,
+ * and the next request waits in the RX buffer meanwhile.
+ *
+ * Once called, it takes the Serial port over from the input queue, whose
+ * serial events are still generated from here.
+ *
+ * This function should be called in the loop() as often as possible, and
+ * handleAction() should not be called by the sketch meanwhile a remote motion
+ * is in process.
+ *
+ * @param currentTime  Current time in milliseconds.
+ *
+ * @return  lo nibble -> key [EB_T_KP_KEYS],  hi nibble -> event [EB_T_KP_EVENTS]
+ *          Always 0 with the input queue running, see getInputEvent().
+ *          EB_RM_EVT_PROGRAM if the program was just uploaded, see setRemoteProgram().
+ */
+uint8_t Escornabot::handleRemote(uint32_t currentTime)
+{
+	_remote_on = true;
+
+	// motion in process (DONE waits for the last reply to be sent)
+	if (_remote_command != EB_CMD_NN && handleAction(currentTime, _remote_command) != EB_CMD_R_PENDING_ACTION
+		&& _flushFrame())
+	{
+		_remote_command = EB_CMD_NN;
+		_replyRemote(_remote_move_seq, EB_RM_OP_DONE, EB_RM_ACK);
+	}
+
+	// partial frame timeout
+	if (_remote_state != EB_RM_S_SYNC && currentTime - _remote_btime > EB_RM_FRAME_TIMEOUT)
+		_remote_state = EB_RM_S_SYNC;
+
+	_readSerial(currentTime, true);
+	if (_remote_uploaded)
+	{
+		_remote_uploaded = false;
+		return EB_RM_EVT_PROGRAM;
+	}
+	return _popSerial();
+}  // handleRemote()
+
+/**
+ * Feeds the remote protocol parser with a byte, see handleRemote().
+ *
+ * @param data  Byte received.
+ *
+ * @return  true if a complete frame is ready (CRC not checked).
+ */
+bool Escornabot::_parseRemote(uint8_t data)
+{
+	switch (_remote_state)
+	{
+	case EB_RM_S_SYNC:
+		_remote_crc = 0;
+		_remote_state = EB_RM_S_LEN;
+		return false;
+	case EB_RM_S_LEN:
+		// too long: not a frame, resync
+		_remote_state = data > EB_RM_MAX_PAYLOAD ? EB_RM_S_SYNC : EB_RM_S_SEQ;
+		_remote_len = data;
+		break;
+	case EB_RM_S_SEQ:
+		_remote_seq = data;
+		_remote_state = EB_RM_S_OP;
+		break;
+	case EB_RM_S_OP:
+		_remote_op = data;
+		_remote_count = 0;
+		_remote_state = _remote_len ? EB_RM_S_PAYLOAD : EB_RM_S_CRC;
+		break;
+	case EB_RM_S_PAYLOAD:
+		_remote_payload[_remote_count++] = data;
+		if (_remote_count == _remote_len) _remote_state = EB_RM_S_CRC;
+		break;
+	case EB_RM_S_CRC:
+		_remote_state = EB_RM_S_SYNC;
+		_remote_crc ^= data; // 0 if right
+		return true;
+	}
+	_remote_crc = _crc8_ccitt_update(_remote_crc, data);
+	return false;
+}  // _parseRemote()
+
+/**
+ * Executes the frame just received and replies to it, see handleRemote().
+ *
+ * @param currentTime  Current time in milliseconds.
+ */
+void Escornabot::_execRemote(uint32_t currentTime)
+{
+	uint8_t *p = _remote_payload;
+	uint8_t reply[EB_RM_MAX_PAYLOAD];  // status + data
+	uint8_t length = 1;  // data after the status
+	uint8_t status = EB_RM_ACK;
+
+	if (_remote_crc)
+	{
+		_replyRemote(_remote_seq, _remote_op, EB_RM_NACK_CRC);
+		return;
+	}
+
+	switch (_remote_op)
+	{
+	case EB_RM_OP_PING:
+		break;
+	case EB_RM_OP_MOVE:
+		if (_remote_len != 3) status = EB_RM_NACK_LENGTH;
+		else if (p[0] == EB_CMD_NN || p[0] > EB_CMD_TR_ALT) status = EB_RM_NACK_VALUE;
+		else if (_remote_command != EB_CMD_NN || _exec_steps || _melody_tune
+			|| (_remote_program && _remote_program->isRunning())) status = EB_RM_NACK_BUSY;
+		else
+		{
+			_remote_command = (EB_T_COMMANDS)p[0];
+			_remote_move_seq = _remote_seq;
+			int16_t value = p[1] | p[2] << 8;
+			bool turn = _remote_command == EB_CMD_TL || _remote_command == EB_CMD_TR
+				|| _remote_command == EB_CMD_TL_ALT || _remote_command == EB_CMD_TR_ALT;
+			prepareAction(_remote_command, turn ? value : value / 10.0);  // mm -> cms
+		}
+		break;
+	case EB_RM_OP_STOP:
+		if (_remote_program) _remote_program->stop(currentTime); // the sketch sees EB_PR_R_IDLE
+		stopAction(currentTime);
+		_remote_command = EB_CMD_NN;
+		break;
+	case EB_RM_OP_TONE:
+		if (_remote_len != 4) status = EB_RM_NACK_LENGTH;
+		else playTone(p[0] | p[1] << 8, p[2] | p[3] << 8, false);
+		break;
+	case EB_RM_OP_BEEP:
+		if (_remote_len != 3) status = EB_RM_NACK_LENGTH;
+		else if (p[0] > EB_BEEP_BACKWARD) status = EB_RM_NACK_VALUE;
+		else beep((EB_T_BEEPS)p[0], p[1] | p[2] << 8);
+		break;
+	case EB_RM_OP_COLOR:
+		if (_remote_len != 3) status = EB_RM_NACK_LENGTH;
+		else showColor(p[0], p[1], p[2]);
+		break;
+	case EB_RM_OP_LED:
+		if (_remote_len != 1) status = EB_RM_NACK_LENGTH;
+		else turnLED(p[0] ? HIGH : LOW);
+		break;
+	case EB_RM_OP_STATUS:
+	{
+		uint32_t steps;
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { steps = _exec_steps; }
+		reply[length++] = _remote_command != EB_CMD_NN || steps || _melody_tune
+			|| (_remote_program && _remote_program->isRunning());
+		reply[length++] = getPressedKey();
+		for (uint8_t i = 0; i < 4; i++, steps >>= 8) reply[length++] = steps;
+		break;
+	}
+	case EB_RM_OP_VERSION:
+		for (const char *v = EB_VERSION; *v; v++) reply[length++] = *v;
+		break;
+	case EB_RM_OP_KEYPAD:
+		for (uint8_t i = 0; i < EB_T_KP_KEYS_SIZE; i++)
+		{
+			reply[length++] = _keypad_values[i];
+			reply[length++] = _keypad_values[i] >> 8;
+		}
+		break;
+	case EB_RM_OP_CONFIG:
+	{
+		if (_remote_len != 3) { status = EB_RM_NACK_LENGTH; break; }
+		uint16_t value = p[1] | p[2] << 8;
+		switch (p[0])
+		{
+		case EB_RM_CFG_STEPS_MM:
+			if (value) setStepsPerMilimiter(value / 100.0);
+			else status = EB_RM_NACK_VALUE;
+			break;
+		case EB_RM_CFG_STEPS_DEG:
+			if (value) setStepsPerDegree(value / 100.0);
+			else status = EB_RM_NACK_VALUE;
+			break;
+		case EB_RM_CFG_BRIGHTNESS:
+			if (value <= 255) setBrightness(value);
+			else status = EB_RM_NACK_VALUE;
+			break;
+		case EB_RM_CFG_TELEMETRY:
+			if (value) startTelemetry(value);
+			else stopTelemetry();
+			break;
+		default:
+			status = EB_RM_NACK_VALUE;
+		}
+		break;
+	}
+	case EB_RM_OP_UPLOAD:
+	{
+		if (! _remote_program) { status = EB_RM_NACK_OPCODE; break; }
+		uint16_t offset = p[0] | p[1] << 8;
+		uint8_t n = p[2];
+		if (_remote_len < 3 || _remote_len != 3 + (n + 1) / 2) { status = EB_RM_NACK_LENGTH; break; }
+		if (offset > _remote_program->getCount() || offset + n > _remote_program->getCapacity()) { status = EB_RM_NACK_VALUE; break; }
+		if (_remote_command != EB_CMD_NN || _exec_steps || _melody_tune || _remote_program->isRunning()) { status = EB_RM_NACK_BUSY; break; }
+		for (uint8_t i = 0; i < n; i++)
+		{
+			uint8_t command = (p[3 + i / 2] >> ((i & 1) * 4)) & B1111;
+			if (command == EB_CMD_NN || command > EB_CMD_TR_ALT) { status = EB_RM_NACK_VALUE; break; }
+		}
+		if (status != EB_RM_ACK) break;
+		// valid: replace from offset on
+		while (_remote_program->getCount() > offset) _remote_program->undo();
+		for (uint8_t i = 0; i < n; i++)
+			_remote_program->append((EB_T_COMMANDS)((p[3 + i / 2] >> ((i & 1) * 4)) & B1111));
+		reply[length++] = offset + n;
+		reply[length++] = (offset + n) >> 8;
+		_remote_uploaded = true;
+		break;
+	}
+	case EB_RM_OP_DOWNLOAD:
+	{
+		if (! _remote_program) { status = EB_RM_NACK_OPCODE; break; }
+		if (_remote_len != 2) { status = EB_RM_NACK_LENGTH; break; }
+		uint16_t count = _remote_program->getCount(), offset = p[0] | p[1] << 8;
+		if (offset > count) { status = EB_RM_NACK_VALUE; break; }
+		uint16_t n = count - offset;
+		if (n > (EB_RM_MAX_PAYLOAD - 6) * 2) n = (EB_RM_MAX_PAYLOAD - 6) * 2; // the rest, in next frames
+		reply[length++] = count;
+		reply[length++] = count >> 8;
+		reply[length++] = offset;
+		reply[length++] = offset >> 8;
+		reply[length++] = n;
+		for (uint8_t i = 0; i < n; i += 2)
+		{
+			uint8_t pair = _remote_program->getCommand(offset + i);
+			if (i + 1 < n) pair |= _remote_program->getCommand(offset + i + 1) << 4;
+			reply[length++] = pair;
+		}
+		break;
+	}
+	default:
+		status = EB_RM_NACK_OPCODE;
+	}
+	reply[0] = status;
+	logEvent(EB_LOG_REMOTE, _remote_op, status);
+	_sendFrame(_remote_seq, _remote_op | EB_RM_OP_REPLY, reply, status == EB_RM_ACK ? length : 1);
+}  // _execRemote()
+
+/**
+ * Sends a reply frame of the remote protocol without data, see handleRemote().
+ *
+ * @param seq     Sequence number of the request.
+ * @param op      Opcode of the request (EB_RM_OP_REPLY is added).
+ * @param status  EB_RM_ACK or EB_RM_NACK_*.
+ */
+void Escornabot::_replyRemote(uint8_t seq, uint8_t op, uint8_t status)
+{
+	_sendFrame(seq, op | EB_RM_OP_REPLY, &status, 1);
+}  // _replyRemote()
+
+/**
+ * Lets the remote app upload (EB_RM_OP_UPLOAD) and download
+ * (EB_RM_OP_DOWNLOAD) the program of the sketch, up to 128 commands per
+ * frame, see handleRemote(). After an upload, handleRemote() returns
+ * EB_RM_EVT_PROGRAM. Uploads are refused while the program is running.
+ *
+ * @param program  Program of the sketch (NULL disables the transfers).
+ */
+void Escornabot::setRemoteProgram(ProgramRunner *program)
+{
+	_remote_program = program;
+}  // setRemoteProgram()
+
+/**
+ * Sends a frame of the remote protocol: SYNC LEN SEQ OP PAYLOAD CRC. It
+ * never blocks: what doesn't fit in the TX buffer is sent by the next calls
+ * to _flushFrame(), which must return true before sending another one.
+ *
+ * @param seq   Sequence number.
+ * @param op    Opcode.
+ * @param data  Payload.
+ * @param len   Payload length.
+ */
+void Escornabot::_sendFrame(uint8_t seq, uint8_t op, const uint8_t *data, uint8_t len)
+{
+	uint8_t *f = _remote_tx;
+	*f++ = EB_RM_SYNC;
+	*f++ = len;
+	*f++ = seq;
+	*f++ = op;
+	memcpy(f, data, len);
+	f += len;
+	uint8_t crc = 0;
+	for (uint8_t *b = _remote_tx + 1; b < f; b++) crc = _crc8_ccitt_update(crc, *b);
+	*f++ = crc;
+	_remote_tx_len = f - _remote_tx;
+	_remote_tx_sent = 0;
+	_flushFrame();
+}  // _sendFrame()
+
+/**
+ * Sends the rest of the last frame, as much as fits in the TX buffer.
+ *
+ * @return  true if it's been sent completely (another one can be sent).
+ */
+bool Escornabot::_flushFrame()
+{
+	if (_remote_tx_sent >= _remote_tx_len) return true;
+	uint8_t n = _remote_tx_len - _remote_tx_sent;
+	int16_t room = Serial.availableForWrite();
+	if (room < n) n = room > 0 ? room : 0;
+	Serial.write(_remote_tx + _remote_tx_sent, n);
+	_remote_tx_sent += n;
+	return _remote_tx_sent >= _remote_tx_len;
+}  // _flushFrame()
+
+
+
+////////////////////////////////////////
+//
+// Logo interpreter
+//
+////////////////////////////////////////
+
+/**
+ * Starts the Logo interpreter: the text received through the Serial port is
+ * compiled and executed as it arrives, see handleLogo(). The single
+ * characters of handleSerial() don't work meanwhile (frames of the remote
+ * protocol do, with handleRemote()).
+ */
+void Escornabot::startLogo()
+{
+	_clearLogo();
+	_logo_state = EB_LG_S_WORD;
+	_logo_tlen = 0;
+	_logo_error = false;
+	_logo_on = true;
+}  // startLogo()
+
+/**
+ * Stops the Logo interpreter (and the move in execution, if any).
+ */
+void Escornabot::stopLogo()
+{
+	_logo_on = false;
+	_clearLogo();
+}  // stopLogo()
+
+/**
+ * Reads the Logo script through the Serial port (compiling it into a small
+ * instruction buffer, no String involved) and executes it with
+ * prepareAction()/handleAction(), starting before the rest of the script
+ * has arrived (REPEAT loops wait for their ]). When the buffer is full, the
+ * bytes wait in the RX buffer until the instructions are executed.
+ *
+ * This function should be called in the loop() as often as possible, and
+ * handleAction() should not be called by the sketch meanwhile.
+ *
+ * @param currentTime  Current time in milliseconds.
+ *
+ * @return  EB_LG_R_IDLE, EB_LG_R_RUNNING, EB_LG_R_FINISHED or EB_LG_R_ERROR
+ */
+uint8_t Escornabot::handleLogo(uint32_t currentTime)
+{
+	if (! _logo_on) return EB_LG_R_IDLE;
+	_readSerial(currentTime, false);
+	if (_logo_error)
+	{
+		_logo_error = false;
+		return EB_LG_R_ERROR;
+	}
+
+	// move in execution
+	if (_logo_command != EB_CMD_NN)
+	{
+		if (handleAction(currentTime, _logo_command) == EB_CMD_R_PENDING_ACTION) return EB_LG_R_RUNNING;
+		_logo_command = EB_CMD_NN;
+	}
+
+	// next instructions
+	while (_logo_pc < _logo_len)
+	{
+		uint8_t op = _logo_op[_logo_pc];
+		int16_t arg = _logo_arg[_logo_pc];
+		_logo_busy = true;
+		if (op == EB_LG_OP_REPEAT)
+		{
+			if (arg > 0)
+			{
+				_logo_left[_logo_depth++] = arg;
+				_logo_pc++;
+				continue;
+			}
+			// REPEAT 0: skip up to its END
+			uint8_t end = _logo_pc + 1;
+			while (end < _logo_len && ! (_logo_op[end] == EB_LG_OP_END && _logo_arg[end] == _logo_pc)) end++;
+			if (end == _logo_len) break; // not received yet
+			_logo_pc = end + 1;
+		}
+		else if (op == EB_LG_OP_END)
+		{
+			if (--_logo_left[_logo_depth - 1] > 0) _logo_pc = arg + 1; // again
+			else
+			{
+				_logo_depth--;
+				_logo_pc++;
+			}
+		}
+		else
+		{
+			// move: negative values go the other way
+			EB_T_COMMANDS command = (EB_T_COMMANDS)op;
+			if (arg < 0)
+				switch (command)
+				{
+					case EB_CMD_FW: command = EB_CMD_BW; break;
+					case EB_CMD_BW: command = EB_CMD_FW; break;
+					case EB_CMD_TL: command = EB_CMD_TR; break;
+					case EB_CMD_TR: command = EB_CMD_TL; break;
+					default: break;
+				}
+			prepareAction(command, arg);
+			_logo_command = command;
+			_logo_pc++;
+			return EB_LG_R_RUNNING;
+		}
+	}
+
+	if (_logo_depth || _logo_nopen)
+	{
+		// waiting for the rest of a loop, unless there is no room for it
+		if (_logo_len < EB_LG_CODE_SIZE - 1) return EB_LG_R_RUNNING;
+		_clearLogo();
+		return EB_LG_R_ERROR;
+	}
+	_logo_len = _logo_pc = 0; // all done: room for the next instructions
+	if (! _logo_busy) return EB_LG_R_IDLE;
+	_logo_busy = false;
+	return EB_LG_R_FINISHED;
+}  // handleLogo()
+
+/**
+ * Feeds the Logo tokenizer with a character, see handleLogo().
+ *
+ * @param data  Character received.
+ */
+void Escornabot::_parseLogo(uint8_t data)
+{
+	if (_logo_state == EB_LG_S_SKIP)
+	{
+		if (data == '\n' || data == '\r') _logo_state = EB_LG_S_WORD;
+		return;
+	}
+	if (data == '[' || data == ']' || data <= ' ' || data == ',' || data == ';')
+	{
+		// separators: end of the token in process
+		if (_logo_tlen) _tokenLogo();
+		if ((data == '\n' || data == '\r') && _logo_state == EB_LG_S_SKIP) _logo_state = EB_LG_S_WORD;
+		if (data == '[' || data == ']')
+		{
+			_logo_token[0] = data;
+			_logo_tlen = 1;
+			_tokenLogo();
+		}
+		return;
+	}
+	if (_logo_tlen >= EB_LG_TOKEN_SIZE) _logo_tlen = EB_LG_TOKEN_SIZE + 1; // too long, invalid
+	else _logo_token[_logo_tlen++] = toupper(data);
+}  // _parseLogo()
+
+/**
+ * Compiles the token just received, see handleLogo().
+ */
+void Escornabot::_tokenLogo()
+{
+	bool valid = _logo_tlen <= EB_LG_TOKEN_SIZE;
+	_logo_token[valid ? _logo_tlen : 0] = 0;
+	_logo_tlen = 0;
+	const char *t = _logo_token;
+
+	if (valid) switch (_logo_state)
+	{
+	case EB_LG_S_WORD:
+		_logo_state = EB_LG_S_NUMBER;
+		if (! strcmp_P(t, PSTR("FD")) || ! strcmp_P(t, PSTR("FORWARD"))) _logo_pending = EB_CMD_FW;
+		else if (! strcmp_P(t, PSTR("BK")) || ! strcmp_P(t, PSTR("BACK"))) _logo_pending = EB_CMD_BW;
+		else if (! strcmp_P(t, PSTR("RT")) || ! strcmp_P(t, PSTR("RIGHT"))) _logo_pending = EB_CMD_TR;
+		else if (! strcmp_P(t, PSTR("LT")) || ! strcmp_P(t, PSTR("LEFT"))) _logo_pending = EB_CMD_TL;
+		else if (! strcmp_P(t, PSTR("REPEAT"))) _logo_pending = EB_LG_OP_REPEAT;
+		else
+		{
+			_logo_state = EB_LG_S_WORD;
+			if (! strcmp_P(t, PSTR("STOP")))
+			{
+				_clearLogo();
+				return;
+			}
+			if (t[0] == ']' && _logo_nopen)
+			{
+				_logo_nopen--;
+				_emitLogo(EB_LG_OP_END, _logo_open[_logo_nopen]);
+				return;
+			}
+			valid = false;
+		}
+		break;
+	case EB_LG_S_NUMBER:
+	{
+		int32_t value = 0;
+		uint8_t i = (t[0] == '-');
+		if (! t[i]) valid = false;
+		for (; t[i]; i++)
+		{
+			if (t[i] < '0' || t[i] > '9') valid = false;
+			else if (value < 0x7FFF) value = value * 10 + t[i] - '0';
+		}
+		if (value > 0x7FFF) value = 0x7FFF;
+		if (t[0] == '-') value = -value;
+		if (! valid) break;
+		if (_logo_pending == EB_LG_OP_REPEAT)
+		{
+			if (_logo_nopen >= EB_LG_DEPTH) { valid = false; break; } // too deep
+			_logo_times = value; // see [
+			_logo_state = EB_LG_S_BRACKET;
+		}
+		else
+		{
+			_emitLogo(_logo_pending, value);
+			_logo_state = EB_LG_S_WORD;
+		}
+		break;
+	}
+	case EB_LG_S_BRACKET:
+		if (t[0] != '[') { valid = false; break; }
+		_logo_open[_logo_nopen++] = _logo_len;
+		_emitLogo(EB_LG_OP_REPEAT, _logo_times);
+		_logo_state = EB_LG_S_WORD;
+		break;
+	}
+
+	if (! valid)
+	{
+		_logo_error = true;
+		_logo_state = EB_LG_S_SKIP;
+	}
+}  // _tokenLogo()
+
+/**
+ * Appends an instruction to the Logo code, see handleLogo().
+ *
+ * @param op   Instruction: move [EB_T_COMMANDS], EB_LG_OP_REPEAT or EB_LG_OP_END.
+ * @param arg  Its argument.
+ */
+void Escornabot::_emitLogo(uint8_t op, int16_t arg)
+{
+	if (_logo_len >= EB_LG_CODE_SIZE) return; // shouldn't happen, see _readSerial()
+	_logo_op[_logo_len] = op;
+	_logo_arg[_logo_len] = arg;
+	_logo_len++;
+}  // _emitLogo()
+
+/**
+ * Discards all the Logo code and stops the move in execution, if any.
+ */
+void Escornabot::_clearLogo()
+{
+	if (_logo_command != EB_CMD_NN) stopAction(millis());
+	_logo_command = EB_CMD_NN;
+	_logo_len = _logo_pc = 0;
+	_logo_nopen = _logo_depth = 0;
+	_logo_busy = false;
+}  // _clearLogo()
+
+
+
+////////////////////////////////////////
+//
+// Telemetry
+//
+////////////////////////////////////////
+
+/**
+ * Starts the telemetry stream: every interval, a binary frame of the remote
+ * protocol (EB_RM_OP_TELEMETRY) with the robot state is sent through the
+ * Serial port, see handleTelemetry().
+ *
+ * @param interval  Time between frames, ms (EB_TM_INTERVAL by default).
+ */
+void Escornabot::startTelemetry(uint16_t interval)
+{
+	_telemetry_interval = interval ? interval : 1;
+	_telemetry_ftime = millis();
+	_telemetry_ltime = micros();
+	_telemetry_loops = 0;
+	_telemetry_lmax = 0;
+}  // startTelemetry()
+
+/**
+ * Stops the telemetry stream.
+ */
+void Escornabot::stopTelemetry()
+{
+	_telemetry_interval = 0;
+}  // stopTelemetry()
+
+/**
+ * Measures the loop() timing and sends the telemetry frame when it's time:
+ * elapsed time, pending steps and current command, keypad key & state and
+ * reading, loop() iterations and max duration since the previous frame, and
+ * battery voltage (only with the keypad sampler running).
+ *
+ * It never blocks: the frame is sent only if it fits in the TX buffer (or
+ * it waits for the next call).
+ *
+ * This function should be called in the loop() as often as possible (once
+ * per iteration, to measure it).
+ *
+ * @param currentTime  Current time in milliseconds.
+ *
+ * @return  true if a frame was sent.
+ */
+bool Escornabot::handleTelemetry(uint32_t currentTime)
+{
+	if (! _telemetry_interval) return false; // stopped
+
+	// loop() timing
+	uint32_t cTime = micros();
+	uint32_t lapse = cTime - _telemetry_ltime;
+	_telemetry_ltime = cTime;
+	if (lapse > 0xFFFF) lapse = 0xFFFF;
+	if (lapse > _telemetry_lmax) _telemetry_lmax = lapse;
+	if (_telemetry_loops < 0xFFFF) _telemetry_loops++;
+
+	if (currentTime - _telemetry_ftime < _telemetry_interval) return false; // not yet
+	if (! _flushFrame() || Serial.availableForWrite() < EB_TM_FRAME_SIZE + 5) return false; // no room, later
+
+	uint8_t frame[EB_TM_FRAME_SIZE];
+	uint8_t length = 0;
+	uint32_t steps = _exec_steps;
+	int16_t raw = _keypad_last_value;
+	uint16_t battery = getBatteryVoltage();
+	for (uint8_t i = 0; i < 4; i++) frame[length++] = currentTime >> (i * 8);
+	for (uint8_t i = 0; i < 4; i++) frame[length++] = steps >> (i * 8);
+	frame[length++] = steps ? _exec_command : EB_CMD_NN;
+	frame[length++] = _keypad_key[SAVED] << 4 | _keypad_key_state[PREVIOUS];
+	frame[length++] = raw;
+	frame[length++] = raw >> 8;
+	frame[length++] = _telemetry_loops;
+	frame[length++] = _telemetry_loops >> 8;
+	frame[length++] = _telemetry_lmax;
+	frame[length++] = _telemetry_lmax >> 8;
+	frame[length++] = battery;
+	frame[length++] = battery >> 8;
+	_sendFrame(_telemetry_seq++, EB_RM_OP_TELEMETRY, frame, length);
+
+	_telemetry_ftime = currentTime;
+	_telemetry_loops = 0;
+	_telemetry_lmax = 0;
+	return true;
+}  // handleTelemetry()
+
+/**
+ * Returns the battery voltage (AVcc), read in the background by the keypad
+ * sampler every EB_TM_BATTERY_PERIOD samples, see startKeypadSampler().
+ *
+ * @return  millivolts, 0 if unknown (sampler not running).
+ */
+uint16_t Escornabot::getBatteryVoltage()
+{
+	uint16_t mv;
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		mv = _battery_mv;
+	}
+	return mv;
+}  // getBatteryVoltage()
+
+
+
+////////////////////////////////////////
+//
+// Input queue
+//
+////////////////////////////////////////
+
+/**
+ * Starts queueing the inputs: the keypad sampler records every change of the
+ * keypad reading with its time in the background (~1ms resolution), and
+ * getInputEvent() processes them afterwards, as if handleKeypad() had been
+ * called all along, along with the bytes waiting in the Serial RX buffer. So
+ * no key stroke is lost while the loop() is busy (e.g. delay(), playRTTTL(),
+ * blinkLED()...), and the events can be consumed at any pace.
+ *
+ * @note handleKeypad() and handleSerial() return nothing while it runs.
+ * @note Without EB_KEYPAD_SAMPLER (Config.h) the keypad is only read by
+ *       getInputEvent(), so key strokes made meanwhile may be lost.
+ */
+void Escornabot::startInputQueue()
+{
+	clearInputQueue();
+	_input_value = rawKeypad(); // reading in force
+	_input_ptime = millis();
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_input_slast = _input_value;
+		_input_stail = _input_shead;
+		_input_queued = true;
+	}
+	if (! _keypad_sampling) startKeypadSampler();
+}  // startInputQueue()
+
+/**
+ * Stops queueing the inputs: handleKeypad() and handleSerial() work again
+ * (the keypad sampler keeps running).
+ */
+void Escornabot::stopInputQueue()
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		_input_queued = false;
+	}
+}  // stopInputQueue()
+
+/**
+ * Gets the oldest input event in the queue, if any.
+ *
+ * @param event  Where the event is copied.
+ *
+ * @return  true if an event was copied, false if the queue is empty.
+ */
+bool Escornabot::getInputEvent(EB_T_INPUT_EVENT &event)
+{
+	if (_input_queued) _pumpInput();
+	if (_input_tail == _input_head) return false; // empty
+	event = _input_queue[_input_tail];
+	_input_tail = (_input_tail + 1) & (EB_IN_QUEUE_SIZE - 1);
+	return true;
+}  // getInputEvent()
 
 /**
- * Clear all internal states of the keypad management process.
- *
- * @param currentTime  Current time in milliseconds (should be provided).
+ * Discards all the events in the queue, e.g. key strokes made while stopping.
  */
-void Escornabot::clearKeypad(uint32_t currentTime)
+void Escornabot::clearInputQueue()
 {
-	memset(_keypad_key, 0, sizeof(_keypad_key));
-	memset(_keypad_key_state, 0, sizeof(_keypad_key_state));
-	memset(_keypad_pressed_time, 0, sizeof(_keypad_pressed_time));
-	_keypad_previousTime = currentTime;
-}  // clearKeypad()
+	_input_tail = _input_head;
+}  // clearInputQueue()
 
 /**
- * Checks if the named button is being pressed.
- *
- * Helper function for mBlock3 extension.
+ * Returns the number of input events lost because the queue was full.
  *
- * @param label  Name of the button to check.
- * @return true if the button is active, false otherwise.
+ * @return  events lost since init()
  */
-bool Escornabot::isButtonPressed(String label)
+uint16_t Escornabot::getInputOverflows()
 {
-	int8_t keyPressed = getPressedKey();
-	if (label == EB_KP_KEYS_LABELS[keyPressed]) return true;
-	return false;
-}  // isButtonPressed()
+	return _input_overflows;
+}  // getInputOverflows()
 
 /**
- * Lowest level reading function of the keypad input pin.
- *
- * @return Analog reading output of the keypad pin.
+ * Processes the keypad reading changes recorded by the sampler since the
+ * last call, with the same engine as handleKeypad() at its resolution
+ * (EB_KP_CHECK_MIN_INTERVAL), and the bytes received, pushing the events
+ * into the queue. Up to EB_IN_REPLAY_MAX ms are caught up. Without the
+ * sampler running nothing is recorded, so only the current reading is.
  */
-int16_t Escornabot::rawKeypad()
+void Escornabot::_pumpInput()
 {
-	return analogRead(_keypad_pin);
-}  // rawKeypad()
+	uint8_t head = _input_shead; // records until here are complete...
+	uint32_t currentTime = millis(); // ...and older than now
+	while (_input_stail != head)
+	{
+		EB_T_INPUT_SAMPLE sample = _input_samples[_input_stail];
+		// back to 32 bits, from now (a record can't be older than 65s)
+		_replayKeypad(currentTime - (uint16_t)((uint16_t)currentTime - sample.time));
+		_input_value = sample.value;
+		_input_stail = (_input_stail + 1) & (EB_IN_SAMPLES_SIZE - 1);
+	}
+	_input_value = rawKeypad(); // now (changes lost if it was full)
+	if (! _keypad_sampling && (int32_t)(currentTime - _input_ptime) > EB_KP_CHECK_MIN_INTERVAL)
+		_input_ptime = currentTime - EB_KP_CHECK_MIN_INTERVAL - 1; // no history: just now, as handleKeypad()
+	_replayKeypad(currentTime);
+	if (! _remote_on && ! _logo_on) _readSerial(currentTime, false); // else, see handleRemote() & handleLogo()
+}  // _pumpInput()
 
 /**
- * Returns the current keypad keys values in use.
+ * Runs the keypad engine from the last time processed up to the given one,
+ * with the reading in force then, see _pumpInput().
  *
- * @return Array with the keypad keys values: NN, FW, TL, GO, TR, BW.
+ * @param until  Time to reach, ms.
  */
-int16_t* Escornabot::getKeypadValues()
+void Escornabot::_replayKeypad(uint32_t until)
 {
-	return _keypad_values;
-}  // getKeypadValues()
-
-
-
-
-////////////////////////////////////////
-//
-// Serial / Blueetooth
-//
-////////////////////////////////////////
+	if ((int32_t)(until - _input_ptime) > EB_IN_REPLAY_MAX) _input_ptime = until - EB_IN_REPLAY_MAX; // too late
+	if (_wizard_state) _input_ptime = until; // in use by the configuration wizard
+	_input_replaying = true;
+	while ((int32_t)(until - _input_ptime) > EB_KP_CHECK_MIN_INTERVAL)
+	{
+		_input_ptime += EB_KP_CHECK_MIN_INTERVAL + 1;
+		uint8_t code = _processKeypad(_input_ptime);
+		if (code) _pushInput(_input_ptime, code, EB_IN_SRC_KEYPAD);
+	}
+	_input_replaying = false;
+}  // _replayKeypad()
 
 /**
- * Processes data comming through the Serial port and converts it into useful
- * info, with the same format as handleKeypad().
- *
- * This is a high level management function, valid for logic control.
- * This function should be called in the loop() as often as possible.
- *
- * @return  lo nibble -> key [EB_T_KP_KEYS],  hi nibble -> event [EB_T_KP_EVENTS]
+ * Adds an event to the queue, or counts it as lost if it's full.
  */
-uint8_t Escornabot::handleSerial()
+void Escornabot::_pushInput(uint32_t time, uint8_t code, uint8_t source)
 {
-	char key = Serial.read();
-	switch (key)
+	uint8_t next = (_input_head + 1) & (EB_IN_QUEUE_SIZE - 1);
+	if (next == _input_tail)
 	{
-	case 'n':
-		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_FW);
-		break;
-	case 'w':
-		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_TL);
-		break;
-	case 'g':
-		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_GO);
-		break;
-	case 'e':
-		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_TR);
-		break;
-	case 's':
-		return ((EB_KP_EVT_RELEASED << 4) | EB_KP_KEY_BW);
-		break;
-	case 'N':
-		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_FW);
-		break;
-	case 'W':
-		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_TL);
-		break;
-	case 'G':
-		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_GO);
-		break;
-	case 'E':
-		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_TR);
-		break;
-	case 'S':
-		return ((EB_KP_EVT_LONGPRESSED << 4) | EB_KP_KEY_BW);
-		break;
-	default:
-		return 0; // just ignore it, even CR & LF
+		_input_overflows++; // full, the newest is lost
+		return;
 	}
-}  // handleSerial()
+	_input_queue[_input_head].time = time;
+	_input_queue[_input_head].code = code;
+	_input_queue[_input_head].source = source;
+	_input_head = next;
+}  // _pushInput()
 
 
 
@@ -872,6 +2939,9 @@ uint8_t Escornabot::handleSerial()
  */
 void Escornabot::prepareAction(EB_T_COMMANDS command, float value)
 {
+	// cancel melody (if any)
+	if (_melody_tune) stopAction(0);
+	_exec_command = command;
 	// fixReversed - stepper motors with swapped cables
 	if (_isReversed)
 		switch (command)
@@ -928,16 +2998,8 @@ void Escornabot::prepareAction(EB_T_COMMANDS command, float value)
 	_exec_dp = _exec_steps * 27 / 100;  // deceleration point: 27% (final stretch)
 	if (_exec_dp > 230) _exec_dp = 230;
 
-	#ifdef EB_DEBUG_MODE
-	Serial.print("PREPARING ");
-	Serial.println(EB_CMD_LABELS[command]);
-	Serial.print("Total STEPS: ");
-	Serial.println(_exec_steps);
-	Serial.print("Acceleration point: ");
-	Serial.println(_exec_ap);
-	Serial.print("Deceleration point: ");
-	Serial.println(_exec_dp);
-	#endif
+	logEvent(EB_LOG_PREPARE, command, _exec_steps > 0x7FFF ? 0x7FFF : _exec_steps);
+	logEvent(EB_LOG_POINTS, _exec_ap, _exec_dp);
 }  // prepareAction()
 
 /**
@@ -953,6 +3015,7 @@ void Escornabot::prepareAction(EB_T_COMMANDS command, float value)
  */
 uint8_t Escornabot::handleAction(uint32_t currentTime, EB_T_COMMANDS command)
 {
+	if (_melody_tune) return _handleMelody(currentTime); // playing through the steppers
 	if (_exec_steps == 0) return 0; // nothing to do
 
 	uint32_t cTime = micros();
@@ -999,6 +3062,9 @@ uint8_t Escornabot::handleAction(uint32_t currentTime, EB_T_COMMANDS command)
 	_exec_ptime = cTime;
 	_inactivity_previousTime = currentTime; // avoid standby alert
 
+	// deferred NeoPixel frame: now there is a whole step interval ahead
+	if (_neopixel_pending) _showNeoPixel();
+
 	// next command?
 	if (_exec_steps > 0) return 1;  // still pending steps
 	return 2;  // finished movement, time for next
@@ -1013,9 +3079,28 @@ uint8_t Escornabot::handleAction(uint32_t currentTime, EB_T_COMMANDS command)
 void Escornabot::stopAction(uint32_t currentTime)
 {
 	// shutdown execution
+	if (_exec_steps) logEvent(EB_LOG_STOP, _exec_steps > 0x7FFF ? 0x7FFF : _exec_steps);
 	_exec_steps = 0;
+	if (_neopixel_pending) _showNeoPixel();
+	if (_melody_tune)
+	{
+		_setMelodyTimer(0);
+		_melody_tune = NULL;
+	}
 }  // stopAction()
 
+/**
+ * Returns the name of a command, stored in flash.
+ *
+ * @param command  Command [EB_T_COMMANDS].
+ * @return the name, to be used with print() and the like (NONE if unknown).
+ */
+const __FlashStringHelper *Escornabot::getCommandLabel(uint8_t command)
+{
+	if (command >= EB_CMD_LABELS_SIZE) command = EB_CMD_NN;
+	return (const __FlashStringHelper *)pgm_read_ptr(&EB_CMD_LABELS_P[command]);
+}  // getCommandLabel()
+
 
 
 ////////////////////////////////////////
@@ -1026,7 +3111,9 @@ void Escornabot::stopAction(uint32_t currentTime)
 
 /**
  * This function takes care of the idle state of the Escornabot.
- * At this moment: avoid powerBank shutdown and alert of inactivity.
+ * At this moment: avoid powerBank shutdown and alert of inactivity, and
+ * write the program being saved (see ProgramRunner::save()) and the drifted
+ * keypad values (see setKeypadAdaptive()).
  *
  * @param currentTime  Current time in milliseconds (should be provided).
  */
@@ -1053,6 +3140,43 @@ void Escornabot::handleStandby(uint32_t currentTime)
 		}
 	}
 
+	// adaptive keypad calibration: save drifted values while idle, in the
+	// background (one byte every time the EEPROM is ready, as programs)
+	if (_keypad_drifted && ! _exec_steps && ! _keypad_key[SAVED])
+	{
+		_keypad_drifted = false;
+		for (uint8_t i = EB_KP_KEY_FW; i < EB_T_KP_KEYS_SIZE; i ++)
+			_keypad_stored[i] = _keypad_values[i];
+		_keypad_store_byte = 1;
+	}
+	if (_keypad_store_byte && ! (EECR & _BV(EEPE)) && ! (eb_program && eb_program->isSaving()))
+	{
+		uint8_t *values = (uint8_t *)&_keypad_stored[EB_KP_KEY_FW]; // same layout as the EEPROM
+		uint8_t *eeprom_index = (uint8_t *)EB_KP_EEPROM_VALUES_INDEX;
+		uint8_t eerie = EECR & _BV(EERIE);
+		EECR &= ~_BV(EERIE);
+		uint8_t i = _keypad_store_byte - 1;
+		while (i < 2 * 5 && eeprom_read_byte(eeprom_index + i) == values[i]) i ++; // unchanged
+		if (i < 2 * 5)
+		{
+			eeprom_write_byte(eeprom_index + i, values[i]); // doesn't wait, the EEPROM is ready
+			_keypad_store_byte = i + 2;
+		}
+		else _keypad_store_byte = 0; // all written
+		EECR |= eerie;
+	}
+
+#ifndef EB_PROGRAM_EE_READY
+	// program being saved: next byte, once the EEPROM is ready
+	if (eb_program && eb_program->isSaving() && ! (EECR & _BV(EEPE)))
+	{
+		ATOMIC_BLOCK(ATOMIC_RESTORESTATE) { eb_program->_stepSave(); }
+	}
+#endif
+
+	// debug log: send it while idle, so its transmission doesn't alter timings
+	if (! _exec_steps && ! _melody_tune) flushDebugLog();
+
 	// alert: "still ON" if enough inactivity
 	if (_inactivity_timeout)  // if timeout enabled
 	if (currentTime - _inactivity_previousTime > _inactivity_timeout)
@@ -1115,4 +3239,423 @@ void Escornabot::debug()
 	Serial.print("Escornabot-lib v");
 	Serial.println(EB_VERSION);
 }  // debug()
+
+/**
+ * Packs a debug log record for transmission, little endian.
+ *
+ * @return  position after the record.
+ */
+static uint8_t *eb_packLogRecord(uint8_t *p, uint16_t time, uint8_t id, int16_t a, int16_t b)
+{
+	*p++ = time;
+	*p++ = time >> 8;
+	*p++ = id;
+	*p++ = a;
+	*p++ = a >> 8;
+	*p++ = b;
+	*p++ = b >> 8;
+	return p;
+}  // eb_packLogRecord()
+
+/**
+ * Stores an event in the binary debug log, in RAM: no time spent on the
+ * Serial port. The log is sent while idle (see handleStandby() and
+ * flushDebugLog()), to be decoded by extras/decode_log.py.
+ *
+ * @param id  Event [EB_LOG_*], from EB_LOG_USER for the sketches.
+ * @param a   First argument.
+ * @param b   Second argument.
+ */
+void Escornabot::logEvent(uint8_t id, int16_t a, int16_t b)
+{
+	uint32_t time = millis();
+	if ((uint16_t)(time >> 16) != _log_epoch)
+	{
+		// records only keep 16 bits: the rest, for the decoder to resync after ~65s
+		_log_epoch = time >> 16;
+		logEvent(EB_LOG_TIME, _log_epoch, 0);
+	}
+	uint8_t next = (_log_head + 1) & (EB_LOG_SIZE - 1);
+	if (next == _log_tail)
+	{
+		_log_lost++; // full, the newest is lost
+		return;
+	}
+	_log[_log_head].time = time;
+	_log[_log_head].id = id;
+	_log[_log_head].a = a;
+	_log[_log_head].b = b;
+	_log_head = next;
+}  // logEvent()
+
+/**
+ * Sends the records of the debug log that fit in the TX buffer (it never
+ * blocks) in EB_RM_OP_LOG frames of the remote protocol.
+ */
+void Escornabot::flushDebugLog()
+{
+	uint8_t frame[EB_LOG_RECORD_SIZE * 8];
+	while (_log_tail != _log_head || _log_lost)
+	{
+		if (! _flushFrame()) return; // a reply in process, later
+		int16_t room = (Serial.availableForWrite() - 5) / EB_LOG_RECORD_SIZE; // SYNC LEN SEQ OP CRC
+		if (room < 1) return; // later
+		if (room > 8) room = 8;
+		uint8_t *p = frame;
+		for (; room > 0 && _log_tail != _log_head; room--)
+		{
+			EB_T_LOG_RECORD *r = &_log[_log_tail];
+			p = eb_packLogRecord(p, r->time, r->id, r->a, r->b);
+			_log_tail = (_log_tail + 1) & (EB_LOG_SIZE - 1);
+		}
+		if (room > 0 && _log_lost && _log_tail == _log_head)
+		{
+			// then, the records lost (the newest ones)
+			p = eb_packLogRecord(p, millis(), EB_LOG_LOST, _log_lost, 0);
+			_log_lost = 0;
+		}
+		_sendFrame(_log_seq++, EB_RM_OP_LOG, frame, p - frame);
+	}
+}  // flushDebugLog()
+#endif
+
+
+
+////////////////////////////////////////
+//
+// Program runner
+//
+////////////////////////////////////////
+
+/**
+ * Constructor. The last program saved is restored by Escornabot::init().
+ *
+ * @param robot  Escornabot executing the program.
+ */
+ProgramRunner::ProgramRunner(Escornabot &robot) : _robot(robot)
+{
+	eb_program = this;
+}  // ProgramRunner()
+
+/**
+ * Adds a command at the end of the program.
+ *
+ * @param command  Command to be added [EB_T_COMMANDS].
+ * @return false if the program is full (or the command is invalid).
+ */
+bool ProgramRunner::append(EB_T_COMMANDS command)
+{
+	if (_count >= EB_PR_CAPACITY || command == EB_CMD_NN || command > EB_CMD_TR_ALT) return false;
+	uint8_t *pair = &_program[_count >> 1];
+	if (_count & 1) *pair = (*pair & B1111) | command << 4;
+	else *pair = command;
+	_count++;
+	return true;
+}  // append()
+
+/**
+ * Removes the last command of the program.
+ *
+ * @return the command removed (EB_CMD_NN if the program is empty).
+ */
+EB_T_COMMANDS ProgramRunner::undo()
+{
+	EB_T_COMMANDS command = getCommand(_count - 1);  // NN if empty
+	if (_count) _count--;
+	return command;
+}  // undo()
+
+/**
+ * Removes all the commands of the program (stop() it first if running).
+ */
+void ProgramRunner::clear()
+{
+	_count = 0;
+}  // clear()
+
+/**
+ * Returns a command of the program.
+ *
+ * @param index  Position in the program, from 0.
+ * @return the command (EB_CMD_NN if out of the program).
+ */
+EB_T_COMMANDS ProgramRunner::getCommand(uint16_t index)
+{
+	if (index >= _count) return EB_CMD_NN;
+	return (EB_T_COMMANDS)((_program[index >> 1] >> ((index & 1) * 4)) & B1111);
+}  // getCommand()
+
+/**
+ * @return # commands in the program.
+ */
+uint16_t ProgramRunner::getCount()
+{
+	return _count;
+}  // getCount()
+
+/**
+ * @return max # commands in the program (EB_PR_CAPACITY).
+ */
+uint16_t ProgramRunner::getCapacity()
+{
+	return EB_PR_CAPACITY;
+}  // getCapacity()
+
+/**
+ * @return true if no more commands can be added.
+ */
+bool ProgramRunner::isFull()
+{
+	return _count >= EB_PR_CAPACITY;
+}  // isFull()
+
+/**
+ * Sets the values of the actions of the commands, used from the next command
+ * on (e.g. a longer distance after a diagonal turn).
+ *
+ * @param distance    cms of FW, BW and PA (same time as the movement).
+ * @param degrees     Degrees of TL and TR.
+ * @param degreesAlt  Degrees of TL_ALT and TR_ALT.
+ */
+void ProgramRunner::setValues(float distance, float degrees, float degreesAlt)
+{
+	_distance = distance;
+	_degrees = degrees;
+	_degrees_alt = degreesAlt;
+}  // setValues()
+
+/**
+ * Starts the execution of the program, from its first command, see
+ * handleProgram().
+ *
+ * @param currentTime  Current time in milliseconds (should be provided).
+ * @param wait         Pause before the first command, ms.
+ */
+void ProgramRunner::start(uint32_t currentTime, uint16_t wait)
+{
+	_next = 0;
+	_command = EB_CMD_NN;
+	_start_time = currentTime;
+	_start_wait = wait;
+	_running = true;
+}  // start()
+
+/**
+ * Stops the execution of the program (the commands are kept).
+ *
+ * @param currentTime  Current time in milliseconds (should be provided).
+ */
+void ProgramRunner::stop(uint32_t currentTime)
+{
+	if (! _running) return;
+	_robot.stopAction(currentTime);
+	_running = false;
+}  // stop()
+
+/**
+ * Executes the program, one command after another, through prepareAction()
+ * and handleAction(). This function keeps its own internal state and should
+ * be called in the loop() as frequently as possible.
+ *
+ * @param currentTime  Current time in milliseconds (should be provided).
+ *
+ * @return  EB_PR_R_IDLE if not running
+ *          EB_PR_R_PENDING if executing a command (or waiting to start)
+ *          EB_PR_R_NEXT if the next command has just started (e.g. to show
+ *                       its color), see getIndex()
+ *          EB_PR_R_FINISHED if the last command has just finished
+ */
+uint8_t ProgramRunner::handleProgram(uint32_t currentTime)
+{
+	if (! _running) return EB_PR_R_IDLE;
+	if (_start_wait)
+	{
+		if (currentTime - _start_time < _start_wait) return EB_PR_R_PENDING;
+		_start_wait = 0;
+	}
+	if (_robot.handleAction(currentTime, _command) == EB_CMD_R_PENDING_ACTION) return EB_PR_R_PENDING;
+
+	// finished (or nothing to do, e.g. 0 cms): next command
+	if (_next >= _count)
+	{
+		_running = false;
+		return EB_PR_R_FINISHED;
+	}
+	_command = getCommand(_next++);
+	switch (_command)
+	{
+	case EB_CMD_TL:
+	case EB_CMD_TR:
+		_robot.prepareAction(_command, _degrees);
+		break;
+	case EB_CMD_TL_ALT:
+	case EB_CMD_TR_ALT:
+		_robot.prepareAction(_command, _degrees_alt);
+		break;
+	default:  // FW, BW, PA
+		_robot.prepareAction(_command, _distance);
+	}
+	return EB_PR_R_NEXT;
+}  // handleProgram()
+
+/**
+ * @return true while the program is being executed.
+ */
+bool ProgramRunner::isRunning()
+{
+	return _running;
+}  // isRunning()
+
+/**
+ * @return position of the command in execution, see getCommand().
+ */
+uint16_t ProgramRunner::getIndex()
+{
+	return _next ? _next - 1 : 0;
+}  // getIndex()
+
+/**
+ * Saves the program in the EEPROM, in the next slot (wear leveling). It is
+ * written in the background, one byte (2 commands) every time the EEPROM is
+ * ready (~3.4ms each), so it never blocks the execution: polled by
+ * Escornabot::handleStandby() or, with EB_PROGRAM_EE_READY defined in
+ * Config.h, by the EE_READY interrupt. If the program is being saved
+ * already, it is saved again once finished.
+ *
+ * @note With EB_PROGRAM_EE_READY, the interrupt may write at any moment
+ *       while isSaving(): the sketch must not access the EEPROM meanwhile
+ *       (the library pauses it for its own accesses).
+ */
+void ProgramRunner::save()
+{
+	ATOMIC_BLOCK(ATOMIC_RESTORESTATE)
+	{
+		if (_saving) _save_again = true;
+		else _startSave();
+	}
+}  // save()
+
+/**
+ * Restores the last program saved in the EEPROM (done by Escornabot::init()).
+ *
+ * @return false if there is no valid program saved (or it's being saved).
+ */
+bool ProgramRunner::restore()
+{
+	if (_saving) return false; // the one in RAM is newer
+	int8_t last = -1;
+	uint8_t seq = 0;
+	for (uint8_t slot = 0; slot < EB_PS_SLOTS; slot++)
+	{
+		if (! _checkSlot(slot)) continue;
+		uint8_t s = eeprom_read_byte((uint8_t *)(EB_PS_EEPROM_START + slot * EB_PS_SLOT_SIZE + 1));
+		if (last < 0 || (int8_t)(s - seq) > 0) { last = slot; seq = s; }  // newer (SEQ wraps)
+	}
+	if (last < 0) return false;
+	const uint8_t *address = (uint8_t *)(EB_PS_EEPROM_START + last * EB_PS_SLOT_SIZE);
+	_count = eeprom_read_word((uint16_t *)(address + 2));
+	eeprom_read_block(_program, address + 4, (_count + 1) / 2);
+	_save_slot = last;
+	_save_seq = seq;
+	return true;
+}  // restore()
+
+/**
+ * @return true while the program is being written in the EEPROM.
+ */
+bool ProgramRunner::isSaving()
+{
+	return _saving;
+}  // isSaving()
+
+/**
+ * Starts writing the program in the next slot, see save() and _isrEEPROM().
+ */
+void ProgramRunner::_startSave()
+{
+	_save_slot = (_save_slot + 1) % EB_PS_SLOTS;
+	_save_seq++;
+	_save_count = _count;
+	_save_step = 0;
+	_save_crc = 0;
+	_saving = true;
+#ifdef EB_PROGRAM_EE_READY
+	EECR |= _BV(EERIE);  // interrupt as soon as the EEPROM is ready
+#endif
+}  // _startSave()
+
+/**
+ * Checks a slot of the EEPROM: MAGIC, count and CRC.
+ *
+ * @param slot  Slot, from 0.
+ * @return true if it holds a valid program.
+ */
+bool ProgramRunner::_checkSlot(uint8_t slot)
+{
+	const uint8_t *address = (uint8_t *)(EB_PS_EEPROM_START + slot * EB_PS_SLOT_SIZE);
+	if (eeprom_read_byte(address) != EB_PS_MAGIC) return false;
+	uint16_t count = eeprom_read_word((uint16_t *)(address + 2));
+	if (count > EB_PR_CAPACITY) return false;
+	uint8_t crc = 0;
+	for (uint8_t i = 1; i < 4 + (count + 1) / 2; i++)
+		crc = _crc8_ccitt_update(crc, eeprom_read_byte(address + i));
+	return crc == eeprom_read_byte(address + 4 + (count + 1) / 2);
+}  // _checkSlot()
+
+/**
+ * Writes the next byte of the program being saved, once the EEPROM is ready.
+ * The MAGIC is erased first and written last: an interrupted save (e.g. a
+ * power cut) leaves an invalid slot, and the previous program is restored.
+ * Bytes already in the EEPROM are skipped.
+ *
+ * @note Internal use only, called with the interrupts disabled.
+ */
+void ProgramRunner::_stepSave()
+{
+	uint16_t size = (_save_count + 1) / 2;  // bytes of commands
+	uint16_t address;
+	uint8_t value;
+	do
+	{
+		if (_save_step > size + 5)
+		{
+			// finished
+			_saving = false;
+			if (_save_again)
+			{
+				_save_again = false;
+				_startSave();
+			}
+#ifdef EB_PROGRAM_EE_READY
+			else EECR &= ~_BV(EERIE);
+#endif
+			return;
+		}
+		address = EB_PS_EEPROM_START + _save_slot * EB_PS_SLOT_SIZE;
+		if (_save_step == 0) value = 0xFF;  // invalid while writing
+		else if (_save_step == size + 5) value = EB_PS_MAGIC;
+		else
+		{
+			address += _save_step;
+			if (_save_step == 1) value = _save_seq;
+			else if (_save_step == 2) value = _save_count;
+			else if (_save_step == 3) value = _save_count >> 8;
+			else if (_save_step < size + 4) value = _program[_save_step - 4];
+			else value = _save_crc;
+			if (_save_step < size + 4) _save_crc = _crc8_ccitt_update(_save_crc, value);
+		}
+		_save_step++;
+	} while (eeprom_read_byte((uint8_t *)address) == value);
+	// write it (EEMPE and EEPE within 4 cycles, interrupts are disabled here)
+	EEAR = address;
+	EEDR = value;
+	EECR |= _BV(EEMPE);
+	EECR |= _BV(EEPE);
+}  // _stepSave()
+
+#ifdef EB_PROGRAM_EE_READY
+ISR(EE_READY_vect)
+{
+	if (eb_program) eb_program->_stepSave();
+}
 #endif
@@ -65,9 +65,34 @@ const uint16_t EB_BEEP_FREQUENCIES[] =
 
 
 
+//
+// LED                               //
+//
+/**
+ * Definition of a blinking pattern for the Escornabot LED: each blink is
+ * on_time milliseconds on and off_time milliseconds off.
+ */
+typedef struct
+{
+	uint16_t on_time;   // ms
+	uint16_t off_time;  // ms
+	uint8_t  times;     // number of blinks, 0 = forever
+} EB_T_LED_PATTERN;
+
+
+
 //
 // NEOPIXEL                          //
 //
+/**
+ * NeoPixel light effects, advanced by handleNeoPixel().
+ */
+typedef enum: uint8_t
+{
+	EB_NP_EFFECT_NONE    = 0,  // no effect in play
+	EB_NP_EFFECT_FADE    = 1,  // linear transition to a color
+	EB_NP_EFFECT_BREATHE = 2,  // sine-shaped on/off cycles of a color
+} EB_T_NP_EFFECTS;
 
 
 
@@ -84,18 +109,16 @@ typedef enum: uint8_t
 	EB_KP_KEY_TL = 2,  // turn left - red
 	EB_KP_KEY_GO = 3,  // go - white
 	EB_KP_KEY_TR = 4,  // turn right - green
-	EB_KP_KEY_BW = 5   // backward - yellow
+	EB_KP_KEY_BW = 5,  // backward - yellow
+	EB_KP_KEY_XX = 6   // invalid reading: out of every key margin
 } EB_T_KP_KEYS;
-#define EB_T_KP_KEYS_SIZE 6
-const String EB_KP_KEYS_LABELS[] =
-{
-	"NONE",
-	"FORWARD",
-	"TURN LEFT",
-	"GO",
-	"TURN RIGHT",
-	"BACKWARD"
-};
+#define EB_T_KP_KEYS_SIZE 6  // valid keys, NN included
+// two-key chords, see configKeypadChord(): codes EB_KP_KEY_CHORD + index
+#define EB_KP_KEY_CHORD   7
+#define EB_KP_CHORDS_SIZE 4
+#define EB_KP_LABELS_SIZE (EB_KP_KEY_CHORD + EB_KP_CHORDS_SIZE)
+// key names in flash (PROGMEM), see getKeyLabel()
+extern const char * const EB_KP_KEYS_LABELS_P[EB_KP_LABELS_SIZE] PROGMEM;
 
 /**
  * Definition of all the possible EVENTs handling an Escornabot keypad.
@@ -106,9 +129,21 @@ typedef enum: uint8_t
 	EB_KP_EVT_PRESSED      = 1,
 	EB_KP_EVT_RELEASED     = 2,
 	EB_KP_EVT_LONGPRESSED  = 3,
-	EB_KP_EVT_LONGRELEASED = 4
+	EB_KP_EVT_LONGRELEASED = 4,
+	EB_KP_EVT_DOUBLECLICK  = 5,  // instead of PRESSED, see setKeypadTimings()
+	EB_KP_EVT_REPEAT       = 6   // while held, see setKeypadTimings()
 } EB_T_KP_EVENTS;
 
+/**
+ * Definition of the filters for the keypad readings, see setKeypadFilter().
+ */
+typedef enum: uint8_t
+{
+	EB_KP_FILTER_NONE    = 0,  // latest sample
+	EB_KP_FILTER_MEDIAN  = 1,  // median of the latest N samples
+	EB_KP_FILTER_AVERAGE = 2   // average of every N samples (decimated)
+} EB_T_KP_FILTERS;
+
 // for code readability
 #define OFF      0
 #define ON       1
@@ -119,9 +154,159 @@ typedef enum: uint8_t
 
 // auto keypad configuration
 #define EB_KP_PULLUP_MARGIN 50
+#define EB_KP_WZ_ALERT_INTERVAL 500  // ms between the starting beeps
+// wizard states
+#define EB_KP_WZ_S_IDLE     0  // not running
+#define EB_KP_WZ_S_ALERT    1  // beeping to warn the user
+#define EB_KP_WZ_S_RELEASE  2  // waiting for no key pressed
+#define EB_KP_WZ_S_PRESS    3  // waiting for the next key
+#define EB_KP_WZ_S_SETTLE   4  // waiting for the reading to settle
+// wizard results
+#define EB_KP_WZ_R_IDLE     0  // not running
+#define EB_KP_WZ_R_RUNNING  1  // in progress
+#define EB_KP_WZ_R_SAVED    2  // finished: values stored and in use
+#define EB_KP_WZ_R_INVALID  3  // finished: values not valid, nothing stored
+#define EB_KP_WZ_R_TIMEOUT  4  // finished: no progress, nothing stored
 // Index to the last 5 uint16_t EEPROM positions;
 // E2END = The last EEPROM address (bytes). 1023 for Arduino Nano 328
 #define EB_KP_EEPROM_VALUES_INDEX (uint16_t *)(E2END - 2 * 5 + 1)
+// EEPROM used by the library, at the end (the rest is free for the sketch):
+//   EB_PS_EEPROM_START..E2END-10  saved programs, see ProgramRunner::save() (482..1013 in a Nano)
+//   E2END-9..E2END                keypad values
+#define EB_PS_EEPROM_START (E2END - 2 * 5 + 1 - EB_PS_SLOTS * EB_PS_SLOT_SIZE)
+
+
+
+//
+// INPUT QUEUE                       //
+//
+/**
+ * Timestamped input event, see getInputEvent().
+ */
+typedef struct
+{
+	uint32_t time;    // ms, when it was detected
+	uint8_t  code;    // lo nibble -> key [EB_T_KP_KEYS], hi nibble -> event [EB_T_KP_EVENTS]
+	uint8_t  source;  // EB_IN_SRC_KEYPAD or EB_IN_SRC_SERIAL
+} EB_T_INPUT_EVENT;
+#define EB_IN_SRC_KEYPAD 1
+#define EB_IN_SRC_SERIAL 2
+
+/**
+ * Keypad reading change, recorded by the sampler for the input queue.
+ */
+typedef struct
+{
+	uint16_t time;   // ms, low half of millis()
+	int16_t  value;  // new reading
+} EB_T_INPUT_SAMPLE;
+
+
+
+//
+// REMOTE PROTOCOL                   //
+//
+/**
+ * Binary frames through the Serial port, see handleRemote():
+ *   SYNC LEN SEQ OP PAYLOAD[LEN] CRC
+ * CRC is the CRC-8 (CCITT) of LEN, SEQ, OP and PAYLOAD. Multibyte values are
+ * little endian. Every request is replied with the same SEQ, OP | REPLY and
+ * a status byte first in the payload (ACK or NACK reason), followed by data.
+ */
+#define EB_RM_SYNC 0xA5
+// opcodes, request payload -> reply payload (after status)
+#define EB_RM_OP_PING    0x00  // -
+#define EB_RM_OP_MOVE    0x01  // command, int16 mm or degrees
+#define EB_RM_OP_STOP    0x02  // -
+#define EB_RM_OP_DONE    0x03  // (robot only) MOVE finished, with its SEQ
+#define EB_RM_OP_TONE    0x10  // uint16 Hz, uint16 ms
+#define EB_RM_OP_BEEP    0x11  // beep [EB_T_BEEPS], uint16 ms
+#define EB_RM_OP_COLOR   0x20  // R, G, B
+#define EB_RM_OP_LED     0x21  // state
+#define EB_RM_OP_STATUS  0x30  // - -> busy, key, uint32 pending steps
+#define EB_RM_OP_VERSION 0x31  // - -> EB_VERSION chars
+#define EB_RM_OP_KEYPAD  0x32  // - -> int16 x EB_T_KP_KEYS_SIZE
+#define EB_RM_OP_CONFIG  0x40  // parameter, uint16 value
+#define EB_RM_OP_TELEMETRY 0x50  // (robot only, SEQ = frame #, no status) uint32 ms,
+                                 // uint32 pending steps, command, key << 4 | state,
+                                 // int16 keypad reading, uint16 loops, uint16 max loop us,
+                                 // uint16 battery mV (0 = unknown)
+#define EB_TM_FRAME_SIZE 18      // telemetry payload, bytes
+#define EB_RM_OP_UPLOAD   0x60   // uint16 offset, n, n commands (2 per byte, lo nibble first) -> uint16 count
+#define EB_RM_OP_DOWNLOAD 0x61   // uint16 offset -> uint16 count, uint16 offset, n, n commands (as upload)
+#define EB_RM_OP_LOG      0x70   // (robot only, SEQ = frame #, no status) debug log records
+#define EB_RM_OP_REPLY   0x80
+// status
+#define EB_RM_ACK         0
+#define EB_RM_NACK_CRC    1
+#define EB_RM_NACK_OPCODE 2
+#define EB_RM_NACK_LENGTH 3
+#define EB_RM_NACK_BUSY   4
+#define EB_RM_NACK_VALUE  5
+// handleRemote() result: program uploaded (key NN, event 0xF)
+#define EB_RM_EVT_PROGRAM 0xF0
+// configuration parameters
+#define EB_RM_CFG_STEPS_MM   1  // steps per mm x 100
+#define EB_RM_CFG_STEPS_DEG  2  // steps per degree x 100
+#define EB_RM_CFG_BRIGHTNESS 3  // NeoPixel brightness
+#define EB_RM_CFG_TELEMETRY  4  // telemetry interval, ms (0 = stop)
+// parser states
+#define EB_RM_S_SYNC    0
+#define EB_RM_S_LEN     1
+#define EB_RM_S_SEQ     2
+#define EB_RM_S_OP      3
+#define EB_RM_S_PAYLOAD 4
+#define EB_RM_S_CRC     5
+
+
+
+//
+// LOGO INTERPRETER                  //
+//
+/**
+ * Turtle/Logo style scripts through the Serial port, see handleLogo():
+ *   FD 15  BK 10  RT 90  LT 45  REPEAT 4 [FD 10 RT 90]  STOP
+ * (FORWARD, BACK, RIGHT and LEFT are accepted too; cms and degrees).
+ */
+// instructions (moves are EB_T_COMMANDS)
+#define EB_LG_OP_REPEAT 0x10  // arg = times
+#define EB_LG_OP_END    0x11  // arg = its REPEAT position
+// parser states
+#define EB_LG_S_WORD    0  // waiting for a command
+#define EB_LG_S_NUMBER  1  // waiting for its value
+#define EB_LG_S_BRACKET 2  // waiting for the [ after REPEAT n
+#define EB_LG_S_SKIP    3  // error: discarding up to the end of the line
+// results
+#define EB_LG_R_IDLE     0  // nothing to do
+#define EB_LG_R_RUNNING  1  // executing or waiting for the rest of the script
+#define EB_LG_R_FINISHED 2  // just finished everything received
+#define EB_LG_R_ERROR    3  // syntax error: rest of the line discarded
+
+
+
+//
+// DEBUG LOG                         //
+//
+/**
+ * Records of the binary debug log (EB_DEBUG_MODE), see logEvent(). They are
+ * sent in EB_RM_OP_LOG frames: uint16 ms (lo 16 bits), id, int16 a, int16 b.
+ */
+typedef struct
+{
+	uint16_t time;  // ms, lo 16 bits
+	uint8_t  id;    // event [EB_LOG_*]
+	int16_t  a;     // arguments
+	int16_t  b;
+} EB_T_LOG_RECORD;
+#define EB_LOG_RECORD_SIZE 7
+// library events
+#define EB_LOG_LOST    0x01  // a = # records lost (log full)
+#define EB_LOG_PREPARE 0x02  // a = command, b = steps
+#define EB_LOG_POINTS  0x03  // a = acceleration point, b = deceleration point
+#define EB_LOG_STOP    0x04  // a = steps pending
+#define EB_LOG_REMOTE  0x05  // a = opcode, b = status
+#define EB_LOG_TIME    0x06  // a = ms, hi 16 bits (logged first when they change)
+#define EB_LOG_USER    0x80  // first event for the sketches
 
 
 
@@ -142,17 +327,9 @@ typedef enum: uint8_t
 	EB_CMD_TL_ALT = 6,  // turn left alternative
 	EB_CMD_TR_ALT = 7   // turn right alternative
 } EB_T_COMMANDS;
-const String EB_CMD_LABELS[] =
-{
-	"NONE",
-	"MOVE FORWARD",
-	"TURN LEFT",
-	"TURN RIGHT",
-	"MOVE BACKWARD",
-	"PAUSE",
-	"TURN LEFT ALT",
-	"TURN RIGHT ALT"
-};
+#define EB_CMD_LABELS_SIZE 8
+// command names in flash (PROGMEM), see getCommandLabel()
+extern const char * const EB_CMD_LABELS_P[EB_CMD_LABELS_SIZE] PROGMEM;
 
 // Return codes for the command handling routine
 #define EB_CMD_R_NOTHING_TO_DO   0
@@ -160,6 +337,27 @@ const String EB_CMD_LABELS[] =
 #define EB_CMD_R_FINISHED_ACTION 2
 
 
+
+//
+// PROGRAM RUNNER                    //
+//
+/**
+ * Programs of commands (up to EB_PR_CAPACITY) stored 2 per byte, see
+ * ProgramRunner, and executed without blocking, see handleProgram().
+ */
+// results
+#define EB_PR_R_IDLE     0  // not running
+#define EB_PR_R_PENDING  1  // executing a command (or waiting to start)
+#define EB_PR_R_NEXT     2  // next command just started, see getIndex()
+#define EB_PR_R_FINISHED 3  // just finished the last command
+// persistence: EEPROM slots used in turns (wear leveling), the valid one with
+// the highest SEQ is restored: MAGIC SEQ uint16 count, commands (packed), CRC8
+#define EB_PS_MAGIC     0xEB  // never in the commands (nibbles <= 7)
+#define EB_PS_SLOT_SIZE (5 + EB_PR_CAPACITY / 2)  // bytes
+
+class ProgramRunner;
+
+
 /**
  * Main class with the core functions and data to program an Escornabot ROBOT.
  */
@@ -182,6 +380,7 @@ public:
 	void disableStepperMotors();
 	void setStepsPerMilimiter(float steps);
 	void setStepsPerDegree(float steps);
+	void prepareMelody(const char* tune);
 
 	// Buzzer
 	void beep(EB_T_BEEPS beepId, uint16_t duration);
@@ -191,13 +390,28 @@ public:
 	// LED
 	void turnLED(uint8_t state);
 	void blinkLED(uint8_t times, bool reversed = false);
+	void startLEDPattern(EB_T_LED_PATTERN pattern, bool reversed = false);
+	void stopLEDPattern();
+	bool handleLED(uint32_t currentTime);
 
 	// NeoPixel
 	void showColor(uint8_t R, uint8_t G, uint8_t B);
 	void showKeyColor(EB_T_KP_KEYS key);
+	void showPixelColor(uint8_t n, uint8_t R, uint8_t G, uint8_t B);
+	void showHeading(int16_t degrees, uint8_t R, uint8_t G, uint8_t B);
+	void setBrightness(uint8_t level);
+	void setGamma(bool enabled);
+	void fadeToColor(uint8_t R, uint8_t G, uint8_t B, uint16_t duration);
+	void breatheColor(uint8_t R, uint8_t G, uint8_t B, uint16_t period, uint8_t times = 0);
+	void stopLightEffect();
+	bool handleNeoPixel(uint32_t currentTime);
+	uint32_t getNeoPixelFramesSent();
+	uint32_t getNeoPixelFramesSkipped();
 
 	// Keypad
 	void autoConfigKeypad(uint8_t keypadPin);
+	void startKeypadWizard();
+	uint8_t handleKeypadWizard(uint32_t currentTime);
 	void configKeypad(
 		uint8_t keypadPin,
 		int16_t keypadValue_NN,
@@ -210,16 +424,56 @@ public:
 	uint8_t handleKeypad(uint32_t currentTime);
 	void clearKeypad(uint32_t currentTime);
 	bool isButtonPressed(String button);
+	bool isButtonPressed(const char *button);
+	bool isButtonPressed(const __FlashStringHelper *button);
+	bool isButtonPressed(EB_T_KP_KEYS key);
+	const __FlashStringHelper *getKeyLabel(uint8_t key);
 	int16_t rawKeypad();
 	int16_t* getKeypadValues();
+	void setKeypadMargin(uint16_t margin);
+	void setKeypadFilter(EB_T_KP_FILTERS filter, uint8_t samples);
+	void setKeypadAdaptive(bool enabled);
+	void setKeypadTimings(
+		uint16_t debounce,
+		uint16_t longPress,
+		uint16_t doubleClick = 0,
+		uint16_t repeatDelay = 0,
+		uint16_t repeatInterval = 0);
+	void configKeypadChord(uint8_t index, EB_T_KP_KEYS key1, EB_T_KP_KEYS key2, int16_t value);
+	void startKeypadSampler();
+	void stopKeypadSampler();
 
 	// Serial / Blueetooth
 	uint8_t handleSerial();
+	uint8_t handleRemote(uint32_t currentTime);
+	void setRemoteProgram(ProgramRunner *program);
+	void setSerialBudget(uint8_t bytes, uint16_t us);
+	uint16_t getSerialOverflows();
+	uint16_t getSerialDropped();
+
+	// Logo interpreter
+	void startLogo();
+	void stopLogo();
+	uint8_t handleLogo(uint32_t currentTime);
+
+	// Telemetry
+	void startTelemetry(uint16_t interval = EB_TM_INTERVAL);
+	void stopTelemetry();
+	bool handleTelemetry(uint32_t currentTime);
+	uint16_t getBatteryVoltage();
+
+	// Input queue
+	void startInputQueue();
+	void stopInputQueue();
+	bool getInputEvent(EB_T_INPUT_EVENT &event);
+	void clearInputQueue();
+	uint16_t getInputOverflows();
 
 	// Commands
 	void prepareAction(EB_T_COMMANDS command, float value);
 	uint8_t handleAction(uint32_t currentTime, EB_T_COMMANDS command);
 	void stopAction(uint32_t currentTime);
+	const __FlashStringHelper *getCommandLabel(uint8_t command);
 
 	// Stand-by
 	void handleStandby(uint32_t currentTime);
@@ -228,6 +482,21 @@ public:
 	// Extra
 	void fixReversed();
 	void debug();
+#ifdef EB_DEBUG_MODE
+	void logEvent(uint8_t id, int16_t a = 0, int16_t b = 0);
+	void flushDebugLog();
+#else
+	void logEvent(uint8_t, int16_t = 0, int16_t = 0) {}  // no-op, see EB_DEBUG_MODE
+	void flushDebugLog() {}
+#endif
+
+	// Interrupt service routines (internal use only)
+#ifdef EB_MELODY_TIMER1
+	void _isrTimer1();
+#endif
+#ifdef EB_KEYPAD_SAMPLER
+	void _isrADC();
+#endif
 
 private:
 	// Stepper motors
@@ -245,12 +514,49 @@ private:
 	float _steppers_steps_mm = STEPPERS_STEPS_MM;   // default from Config.h
 	float _steppers_steps_deg = STEPPERS_STEPS_DEG; // default from Config.h
 
+	// Steppers melody (notes played through the coils, see EB_MELODY_TIMER1)
+	const char* _melody_tune = NULL;  // pending notes of the melody in play (NULL if none)
+	uint32_t _melody_ptime;           // current note start time, ms
+	uint16_t _melody_duration;        // current note duration, ms
+	volatile int16_t _melody_balance; // net steps moved (forward > 0) to stay in place
+	uint8_t _handleMelody(uint32_t currentTime);
+	void _setMelodyTimer(uint16_t frequency);
+	void _stepMelody();
+
 	// Buzzer
 	uint8_t _buzzer_pin; // pin in use
+	// RTTTL parsing
+	uint8_t  _rtttl_octave;    // default octave of the tune in process
+	uint16_t _rtttl_duration;  // default duration of the tune in process
+	uint16_t _rtttl_bpm;       // beats per minute of the tune in process
+	const char* _parseRTTTLHeader(const char* tune);
+	const char* _parseRTTTLNote(const char* tune, uint16_t &frequency, uint16_t &duration);
+
+	// LED
+	EB_T_LED_PATTERN _led_pattern;  // pattern in play
+	uint8_t  _led_blinks = 0;       // pending blinks, 0 = no pattern in play
+	bool     _led_reversed;         // starts with off and ends with on
+	bool     _led_lit;              // current phase: on (true) or off (false)
+	uint32_t _led_ptime;            // current phase start time, ms
 
 	// Neopixel
-	NeoPixel *_neopixel;
+	NeoPixelStatic<NEOPIXEL_COUNT> _neopixel;  // our pixel strip/ring, no heap in use
+	uint32_t _neopixel_sent = 0;            // # frames transmitted
+	uint32_t _neopixel_skipped = 0;         // # frames skipped (no change)
+	bool _neopixel_pending = false;         // frame waiting for a window between steps
 	void _initNeoPixel(int pin);
+	void _showNeoPixel();
+	void _paintNeoPixel(uint32_t color);
+	void _flushNeoPixel();
+	uint32_t _blendColor(uint32_t from, uint32_t to, uint16_t amount);
+	// Light effects
+	EB_T_NP_EFFECTS _effect = EB_NP_EFFECT_NONE;  // effect in play
+	uint32_t _effect_from;      // initial color (fade)
+	uint32_t _effect_to;        // final (fade) or peak (breathe) color
+	uint16_t _effect_duration;  // fade duration or breathe period, ms
+	uint8_t  _effect_times;     // # breathe cycles, 0 = forever
+	uint32_t _effect_stime;     // effect start time, ms
+	uint32_t _effect_ftime;     // last frame time, ms
 
 	// Keypad
 	uint8_t _keypad_pin;                        // pin in use
@@ -259,15 +565,149 @@ private:
 	uint8_t _keypad_key_state[2];               // current and previous
 	uint32_t _keypad_pressed_time[2];           // current and previous
 	uint32_t _keypad_previousTime;              // previous time
+	int16_t _keypad_chord_values[EB_KP_CHORDS_SIZE] = {0};  // analog reading for each chord, 0 = none
+	uint8_t _keypad_chord_keys[EB_KP_CHORDS_SIZE];          // keys of each chord: hi nibble, lo nibble
+	uint8_t _keypad_classes = 0;                                           // # keys and chords in use
+	uint8_t _keypad_order[EB_T_KP_KEYS_SIZE + EB_KP_CHORDS_SIZE];          // keys & chords sorted by analog value
+	int16_t _keypad_bounds[EB_T_KP_KEYS_SIZE + EB_KP_CHORDS_SIZE - 1];     // midpoints between sorted values
+	int16_t _keypadValue(uint8_t key);
+	bool _isKeypadChordOf(uint8_t chord, uint8_t key);
+	// timings, ms
+	uint16_t _keypad_db_time = EB_KP_DB_TIME;          // debouncing
+	uint16_t _keypad_lp_time = EB_KP_LP_MIN_DURATION;  // long press minimum duration
+	uint16_t _keypad_dc_time = EB_KP_DC_MAX_INTERVAL;  // double click max interval, 0 = disabled
+	uint16_t _keypad_rp_delay = EB_KP_RP_DELAY;        // auto-repeat start
+	uint16_t _keypad_rp_interval = EB_KP_RP_INTERVAL;  // auto-repeat interval, 0 = disabled
+	uint8_t  _keypad_click_key = 0;    // last key clicked (double click), XX = second click in process
+	uint32_t _keypad_click_time;       // last click release time
+	uint32_t _keypad_repeat_next;      // next auto-repeat time
+	uint8_t _repeatKeypad(uint32_t currentTime);
+	uint16_t _keypad_margin = EB_KP_VALUE_MARGIN;   // max distance to a key value
+	void _computeKeypadBounds();
+	bool _keypad_sampling = false;              // background ADC sampler running
+	volatile int16_t _keypad_sample = -1;       // latest sampled reading, -1 = none yet
+	EB_T_KP_FILTERS _keypad_filter = EB_KP_FILTER_NONE;  // filter for the samples
+	uint8_t  _keypad_filter_size = 1;                    // # samples filtered
+	int16_t  _keypad_window[EB_KP_FILTER_SIZE];          // latest samples (median)
+	uint8_t  _keypad_windex = 0;                         // next sample position / # samples added
+	bool     _keypad_wfull = false;                      // enough samples for the median
+	uint16_t _keypad_acc = 0;                            // samples sum (average)
+	uint8_t _processKeypad(uint32_t currentTime);
+	// Keypad adaptive calibration
+	bool _keypad_adaptive = false;                // enabled
+	bool _keypad_drifted = false;                 // values to be saved
+	uint8_t _keypad_store_byte = 0;               // next byte to save + 1, 0 = none, see handleStandby()
+	int16_t _keypad_last_value;                   // latest reading classified
+	int16_t _keypad_press_value;                  // latest reading of the key in process
+	uint16_t _keypad_ema[EB_T_KP_KEYS_SIZE];      // key values, fixed point x16
+	int16_t _keypad_stored[EB_T_KP_KEYS_SIZE];    // key values in the EEPROM
+	void _adaptKeypad(uint8_t key, int16_t value);
+	void _storeKeypadValues(const int16_t *values);
+	// Keypad configuration wizard
+	uint8_t  _wizard_state = EB_KP_WZ_S_IDLE;  // current step
+	uint8_t  _wizard_index;                    // beeps done / keys read
+	int16_t  _wizard_values[5];                // FW, TL, GO, TR, BW readings
+	uint32_t _wizard_ptime;                    // last progress time, ms (timeout)
+	uint32_t _wizard_stime;                    // current step start time, ms
+	void _stopKeypadWizard(uint32_t currentTime);
+	bool _isKeypadPressed(int16_t value);
+	bool _validKeypadValues(const int16_t *values);
+
+	// Serial
+	uint8_t _decodeSerial(int16_t data);
+	uint8_t _serial_events[EB_SR_EVENTS_SIZE];        // decoded, pending to be returned (ring buffer)
+	uint8_t _serial_head = 0;                         // next event to be written
+	uint8_t _serial_tail = 0;                         // next event to be read
+	uint8_t _serial_budget_bytes = EB_SR_BUDGET_BYTES;  // max bytes per call
+	uint16_t _serial_budget_us = EB_SR_BUDGET_US;       // max time per call, us
+	uint16_t _serial_overflows = 0;                   // # times the RX buffer was found full
+	uint16_t _serial_dropped = 0;                     // # events lost (pending events full)
+	void _readSerial(uint32_t currentTime, bool remote);
+	uint8_t _popSerial();
+	// Remote protocol
+	bool _remote_on = false;                    // Serial port taken by handleRemote()
+	uint8_t _remote_state = EB_RM_S_SYNC;       // parser state
+	uint8_t _remote_len;                        // payload length of the frame in process
+	uint8_t _remote_seq;                        // sequence number of the frame in process
+	uint8_t _remote_op;                         // opcode of the frame in process
+	uint8_t _remote_count;                      // payload bytes received
+	uint8_t _remote_crc;                        // running CRC
+	uint8_t _remote_payload[EB_RM_MAX_PAYLOAD]; // payload of the frame in process
+	uint32_t _remote_btime;                     // last byte time, ms
+	EB_T_COMMANDS _remote_command = EB_CMD_NN;  // motion in process, requested remotely
+	uint8_t _remote_move_seq;                   // its sequence number (DONE)
+	bool _parseRemote(uint8_t data);
+	void _execRemote(uint32_t currentTime);
+	void _replyRemote(uint8_t seq, uint8_t op, uint8_t status);
+	ProgramRunner *_remote_program = NULL;      // program of the sketch (upload/download)
+	bool _remote_uploaded = false;              // program just uploaded, to be notified
+	uint8_t _remote_tx[EB_RM_MAX_PAYLOAD + 5];  // last frame sent: SYNC LEN SEQ OP PAYLOAD CRC
+	uint8_t _remote_tx_len = 0;                 // its length
+	uint8_t _remote_tx_sent = 0;                // bytes already in the TX buffer
+	void _sendFrame(uint8_t seq, uint8_t op, const uint8_t *data, uint8_t len);
+	bool _flushFrame();
+
+	// Logo interpreter
+	bool _logo_on = false;                      // Serial port taken by handleLogo()
+	uint8_t _logo_state = EB_LG_S_WORD;         // parser state
+	char    _logo_token[EB_LG_TOKEN_SIZE + 1];  // token in process
+	uint8_t _logo_tlen = 0;                     // its length
+	uint8_t _logo_pending;                      // instruction waiting for its value
+	int16_t _logo_times;                        // REPEAT waiting for its [
+	bool    _logo_error = false;                // syntax error, to be notified
+	uint8_t _logo_op[EB_LG_CODE_SIZE];          // compiled instructions
+	int16_t _logo_arg[EB_LG_CODE_SIZE];         // and their arguments
+	uint8_t _logo_len = 0;                      // # instructions compiled
+	uint8_t _logo_pc = 0;                       // next instruction to execute
+	uint8_t _logo_open[EB_LG_DEPTH];            // REPEATs still open (compiling)
+	uint8_t _logo_nopen = 0;                    // # of them
+	int16_t _logo_left[EB_LG_DEPTH];            // iterations left of the REPEATs in execution
+	uint8_t _logo_depth = 0;                    // # of them
+	EB_T_COMMANDS _logo_command = EB_CMD_NN;    // move in execution
+	bool    _logo_busy = false;                 // something executed since last FINISHED
+	void _parseLogo(uint8_t data);
+	void _tokenLogo();
+	void _emitLogo(uint8_t op, int16_t arg);
+	void _clearLogo();
+
+	// Telemetry
+	uint16_t _telemetry_interval = 0;    // time between frames, ms (0 = stopped)
+	uint32_t _telemetry_ftime;           // last frame time, ms
+	uint8_t  _telemetry_seq = 0;         // frame #
+	uint16_t _telemetry_loops = 0;       // calls to handleTelemetry() since last frame
+	uint32_t _telemetry_ltime;           // last call time, us
+	uint16_t _telemetry_lmax = 0;        // max time between calls since last frame, us
+	volatile uint16_t _battery_mv = 0;   // AVcc, mV (0 = unknown)
+	uint8_t _battery_count = 0;          // keypad samples since last reading
+	uint8_t _battery_phase = 0;          // 0 = keypad, 1 = bandgap settling, 2 = bandgap reading
+	uint8_t _battery_admux;              // ADC setup for the keypad
+
+	// Input queue
+	volatile bool _input_queued = false;           // keypad reading changes recorded
+	EB_T_INPUT_EVENT _input_queue[EB_IN_QUEUE_SIZE];  // ring buffer
+	uint8_t _input_head = 0;                       // next event to be written
+	uint8_t _input_tail = 0;                       // next event to be read
+	uint16_t _input_overflows = 0;                 // # events lost (queue full)
+	EB_T_INPUT_SAMPLE _input_samples[EB_IN_SAMPLES_SIZE];  // keypad reading changes (ISR)
+	volatile uint8_t _input_shead = 0;             // next change to be written
+	volatile uint8_t _input_stail = 0;             // next change to be processed
+	int16_t  _input_slast;                         // last reading recorded (ISR)
+	int16_t  _input_value;                         // reading in force at _input_ptime
+	uint32_t _input_ptime;                         // last time processed, ms
+	bool     _input_replaying = false;             // rawKeypad() returns _input_value
+	void _pumpInput();
+	void _replayKeypad(uint32_t until);
+	void _pushInput(uint32_t time, uint8_t code, uint8_t source);
 
 	// Command execution
 	uint32_t _exec_steps;   // # steps for the current action
+	EB_T_COMMANDS _exec_command = EB_CMD_NN;  // current action (as requested)
 	uint32_t _exec_wait;    // delay between steps, microseconds
 	uint32_t _exec_ap;      // acceleration point: #steps until stop accelerating
 	uint32_t _exec_dp;      // deceleration point: #steps to start deceleration
 	uint8_t  _exec_drinit;  // initial driving sequence index
 	int8_t   _exec_drinc;   // driving sequence index growth sign
-	uint32_t _exec_drindex; // driving sequence index
+	volatile uint8_t _exec_drindex; // driving sequence index (also stepped by the Timer1 ISR)
 	uint32_t _exec_ptime;   // previous execution time
 
 	// Stand-by
@@ -278,7 +718,74 @@ private:
 
 	// Extra
 	bool _isReversed = false;
+#ifdef EB_DEBUG_MODE
+	EB_T_LOG_RECORD _log[EB_LOG_SIZE];  // debug log, ring buffer
+	uint8_t  _log_head = 0;             // next record to be written
+	uint8_t  _log_tail = 0;             // next record to be sent
+	uint16_t _log_lost = 0;             // # records lost since last sent (full)
+	uint8_t  _log_seq = 0;              // frame #
+	uint16_t _log_epoch = 0;            // ms, hi 16 bits of the last record
+#endif
 
 };
 
+
+/**
+ * A program of commands, as entered with the keypad, packed 2 per byte, and
+ * its non-blocking execution through the actions of an Escornabot.
+ */
+class ProgramRunner
+{
+public:
+	ProgramRunner(Escornabot &robot);
+
+	// Edition
+	bool append(EB_T_COMMANDS command);
+	EB_T_COMMANDS undo();
+	void clear();
+	EB_T_COMMANDS getCommand(uint16_t index);
+	uint16_t getCount();
+	uint16_t getCapacity();
+	bool isFull();
+
+	// Execution
+	void setValues(float distance, float degrees, float degreesAlt);
+	void start(uint32_t currentTime, uint16_t wait = EB_PR_START_WAIT);
+	void stop(uint32_t currentTime);
+	uint8_t handleProgram(uint32_t currentTime);
+	bool isRunning();
+	uint16_t getIndex();
+
+	// Persistence (EEPROM)
+	void save();
+	bool restore();
+	bool isSaving();
+
+	// EEPROM writing (internal use only, polled or from the EE_READY interrupt)
+	void _stepSave();
+
+private:
+	Escornabot &_robot;
+	uint8_t  _program[EB_PR_CAPACITY / 2];  // commands, 2 per byte (lo nibble first)
+	uint16_t _count = 0;                    // # commands
+	uint16_t _next = 0;                     // next command to be executed
+	EB_T_COMMANDS _command = EB_CMD_NN;     // command in execution
+	bool     _running = false;
+	uint32_t _start_time;                   // ms
+	uint16_t _start_wait = 0;               // pause before the first command, ms
+	float _distance    = 10;  // cms, FW/BW/PA
+	float _degrees     = 90;  // TL/TR
+	float _degrees_alt = 45;  // TL_ALT/TR_ALT
+	// Persistence
+	uint8_t  _save_slot = EB_PS_SLOTS - 1;  // slot of the last program saved
+	uint8_t  _save_seq = 0;                 // its sequence #
+	volatile bool _saving = false;          // being written, see _stepSave()
+	volatile bool _save_again = false;      // changed meanwhile: save() once finished
+	uint16_t _save_count;                   // # commands being saved
+	uint16_t _save_step;                    // next byte to be written
+	uint8_t  _save_crc;
+	void _startSave();
+	bool _checkSlot(uint8_t slot);
+};
+
 #endif  //library